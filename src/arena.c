@@ -0,0 +1,79 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The arena of the request that is handled
+ */
+static struct Arena request = INIT_ARENA();
+
+/**
+ * @brief allocate memory that lives until the arena is released
+ * Small allocations are bumped from the current block, allocations larger
+ * than a block get a block of their own.
+ * @param arena the arena
+ * @param size the size in bytes
+ * @return the memory or NULL on error
+ */
+void *arena_alloc(struct Arena *arena, size_t size) {
+  struct ArenaBlock *block = arena->blocks;
+  size_t align = alignof(max_align_t);
+  size = (size + align - 1) & ~(align - 1);
+  if (!block || block->size - block->used < size) {
+    size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    if (!(block = malloc(sizeof(struct ArenaBlock) + block_size))) {
+      return NULL;
+    }
+    block->used = 0;
+    block->size = block_size;
+    if (arena->blocks && size > ARENA_BLOCK_SIZE) {
+      // keep bumping from the current block after a large allocation
+      block->next = arena->blocks->next;
+      arena->blocks->next = block;
+    } else {
+      block->next = arena->blocks;
+      arena->blocks = block;
+    }
+  }
+  block->used += size;
+  return block->data + block->used - size;
+}
+
+/**
+ * @brief duplicate a string up to a size into an arena
+ * @param arena the arena
+ * @param s the string to be duplicated
+ * @param n the maximum length of the new string
+ * @return the duplicated string or NULL on error
+ */
+char *arena_strndup(struct Arena *arena, const char *s, size_t n) {
+  size_t length = strnlen(s, n);
+  char *dup = arena_alloc(arena, length + 1);
+  if (!dup) {
+    return NULL;
+  }
+  memcpy(dup, s, length);
+  dup[length] = '\0';
+  return dup;
+}
+
+/**
+ * @brief free all memory of an arena at once
+ * @param arena the arena
+ */
+void arena_release(struct Arena *arena) {
+  struct ArenaBlock *block = arena->blocks;
+  while (block) {
+    struct ArenaBlock *next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->blocks = NULL;
+}
+
+/**
+ * @brief get the arena of the request that is handled
+ * It is released once the response has been written.
+ * @return the arena
+ */
+struct Arena *request_arena() { return &request; }
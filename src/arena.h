@@ -0,0 +1,34 @@
+#ifndef RESTCONF_ARENA_H
+#define RESTCONF_ARENA_H
+
+#include <stdalign.h>
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE 8192
+
+/**
+ * A block of arena memory, allocations are bumped from its data
+ */
+struct ArenaBlock {
+  struct ArenaBlock *next;
+  size_t used;
+  size_t size;
+  alignas(max_align_t) char data[];
+};
+
+/**
+ * A bump allocator whose memory is only released as a whole
+ */
+struct Arena {
+  struct ArenaBlock *blocks;
+};
+
+#define INIT_ARENA() \
+  { NULL }
+
+void *arena_alloc(struct Arena *arena, size_t size);
+char *arena_strndup(struct Arena *arena, const char *s, size_t n);
+void arena_release(struct Arena *arena);
+struct Arena *request_arena();
+
+#endif  // RESTCONF_ARENA_H
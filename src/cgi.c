@@ -1,6 +1,8 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 #include "cgi.h"
 #include "restconf.h"
@@ -47,27 +49,72 @@ struct CgiContext *cgi_context_init() {
 void cgi_context_free(struct CgiContext *ctx) { free(ctx); }
 
 /**
- * Get the content passed in stdin
- * @return the allocated content
+ * Get the length of the content passed in stdin
+ * Chunked requests are de-chunked by the web server and passed without a
+ * length, their content is read until the end of stdin.
+ * @param length set to the length, SIZE_MAX for chunked content
+ * @return 0 on success, 1 if there is no valid content length
  */
-char *get_content() {
-  char *post_data;
+int get_content_length(size_t *length) {
   char *length_str;
+  char *encoding;
   char *trailing;
-  unsigned long length;
 
   length_str = getenv("CONTENT_LENGTH");
-  if (!length_str || !*length_str) return NULL;
+  if (!length_str || !*length_str) {
+    encoding = getenv("HTTP_TRANSFER_ENCODING");
+    if (!encoding || strcasecmp(encoding, "chunked") != 0) return 1;
+    *length = SIZE_MAX;
+    return 0;
+  }
 
-  length = strtoul(length_str, &trailing, 10);
-  if (*trailing != '\0' || !length || length > 1024UL * 1024UL) return NULL;
+  *length = strtoul(length_str, &trailing, 10);
+  if (*trailing != '\0' || !*length) return 1;
+  return 0;
+}
 
-  post_data = (char *)malloc(length + 1);
-  if (!post_data) return NULL;
+/**
+ * Parse the JSON content passed in stdin
+ * The content is read in chunks that are fed to an incremental tokener, so
+ * only one chunk of the raw content is held in memory at a time. The tree
+ * grows with the content, so content longer than RESTCONF_MAX_TREE_BODY is
+ * rejected.
+ * @param parse_error set to the error of the tokener
+ * @return the parsed content or NULL on error
+ */
+struct json_object *get_content_json(enum json_tokener_error *parse_error) {
+  char chunk[CONTENT_CHUNK_SIZE];
+  struct json_tokener *tok = NULL;
+  struct json_object *content = NULL;
+  size_t remaining;
+  size_t total = 0;
 
-  if (fread(post_data, sizeof(char), length, stdin) == length) {
-    post_data[length] = '\0';
+  *parse_error = json_tokener_error_parse_eof;
+  if (get_content_length(&remaining)) return NULL;
+  if (remaining != SIZE_MAX && remaining > RESTCONF_MAX_TREE_BODY) {
+    *parse_error = json_tokener_error_size;
+    return NULL;
   }
+  if (!(tok = json_tokener_new())) return NULL;
 
-  return post_data;
-}
\ No newline at end of file
+  while (remaining) {
+    size_t wanted = remaining < sizeof(chunk) ? remaining : sizeof(chunk);
+    size_t read = fread(chunk, sizeof(char), wanted, stdin);
+    if (!read) break;
+    remaining -= read;
+    // chunked content has no length to check up front
+    if ((total += read) > RESTCONF_MAX_TREE_BODY) {
+      *parse_error = json_tokener_error_size;
+      break;
+    }
+    content = json_tokener_parse_ex(tok, chunk, (int)read);
+    if ((*parse_error = json_tokener_get_error(tok)) != json_tokener_continue)
+      break;
+  }
+  if (*parse_error == json_tokener_continue) {
+    // the content ended in the middle of a JSON value
+    *parse_error = json_tokener_error_parse_eof;
+  }
+  json_tokener_free(tok);
+  return *parse_error == json_tokener_success ? content : NULL;
+}
@@ -1,6 +1,20 @@
 #ifndef _CGI_H
 #define _CGI_H
 
+#include <json-c/json.h>
+#include <stddef.h>
+
+#define CONTENT_CHUNK_SIZE 4096
+
+/**
+ * The largest body that is parsed into a JSON tree, larger ones are rejected
+ * as malformed. Only a PUT of a whole top-level container is streamed and not
+ * bounded by it.
+ */
+#ifndef RESTCONF_MAX_TREE_BODY
+#define RESTCONF_MAX_TREE_BODY (1024UL * 1024UL)
+#endif
+
 /**
  * A structure to combine the individual env variables
  */
@@ -17,6 +31,7 @@ struct CgiContext {
 
 struct CgiContext *cgi_context_init();
 void cgi_context_free(struct CgiContext *ctx);
-char *get_content();
+int get_content_length(size_t *length);
+struct json_object *get_content_json(enum json_tokener_error *parse_error);
 
 #endif
\ No newline at end of file
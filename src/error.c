@@ -163,18 +163,27 @@ int print_error(error err) {
       restconf_operation_failed_internal();
       break;
     case NO_SUCH_ELEMENT:
+    case UCI_READ_FAILED:
       restconf_invalid_value();
       break;
     case LIST_UNDEFINED_KEY:
+    case MUST_VIOLATION:
       restconf_operation_failed();
       break;
+    case WHEN_VIOLATION:
+      restconf_unknown_element();
+      break;
     case INVALID_TYPE:
+    case MALFORMED_CONTENT:
       restconf_malformed();
       break;
     case MANDATORY_NOT_PRESENT:
     case KEY_NOT_PRESENT:
       restconf_missing_element();
       break;
+    case LEAFREF_MISSING:
+      restconf_data_missing();
+      break;
     case ELEMENT_ALREADY_EXISTS:
     case IDENTICAL_KEYS:
       restconf_data_exists();
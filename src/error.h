@@ -16,7 +16,11 @@ enum error {
   IDENTICAL_KEYS,
   MANDATORY_NOT_PRESENT,
   MULTIPLE_OBJECTS,
-  DELETING_KEY
+  DELETING_KEY,
+  MALFORMED_CONTENT,
+  LEAFREF_MISSING,
+  MUST_VIOLATION,
+  WHEN_VIOLATION
 };
 typedef enum error error;
 
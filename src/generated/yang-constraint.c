@@ -0,0 +1,52 @@
+#include <stddef.h>
+#include "generated/yang.h"
+#include "yang-xpath.h"
+
+static const struct XPathPath paths[] = {
+    {"restconf-example", "room", NULL, "seats", 1},
+    {NULL, NULL, NULL, NULL, 0}
+};
+
+static const char *const strings[] = {
+    NULL
+};
+
+static const double numbers[] = {
+    0.0,
+    50.0,
+    0
+};
+
+static const char *const must_restconf_example_rooms_seats_0_options[] = {
+    "seats",
+    NULL
+};
+static const struct XPathOp must_restconf_example_rooms_seats_0[] = {
+    {XPATH_PATH, 0},
+    {XPATH_NUMBER, 0},
+    {XPATH_GT, 0},
+};
+
+static const char *const when_restconf_example_rooms_projectors_options[] = {
+    "projectors",
+    NULL
+};
+static const struct XPathOp when_restconf_example_rooms_projectors[] = {
+    {XPATH_PATH, 0},
+    {XPATH_NUMBER, 1},
+    {XPATH_GE, 0},
+};
+
+static const struct YangConstraint constraints[] = {
+    {"restconf-example", "room", NULL, must_restconf_example_rooms_seats_0_options, 0, must_restconf_example_rooms_seats_0, 3},
+    {"restconf-example", "room", NULL, when_restconf_example_rooms_projectors_options, 1, when_restconf_example_rooms_projectors, 3},
+    {NULL, NULL, NULL, NULL, 0, NULL, 0}
+};
+
+static const struct YangConstraints table = {constraints, paths, strings, numbers};
+
+/**
+ * Get the compiled must and when statements of all modules
+ * @return the constraints and the constants their code refers to
+ */
+const struct YangConstraints *yang_constraints() { return &table; }
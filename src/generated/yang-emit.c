@@ -0,0 +1,109 @@
+#include "generated/yang.h"
+#include "uci/uci-emit.h"
+#include "vector.h"
+
+struct map_str2emitter {
+  char *module;
+  char *path;
+  yang_emitter emitter;
+};
+typedef struct map_str2emitter map_str2emitter;
+
+static void emit_restconf_example_course_students(struct UciEmit *emit, const char *key, const struct UciMapSection *section, int flags) {
+  const struct UciMapSection **entries = uci_emit_list_open(emit, key, "student", flags);
+  for (size_t i = 0; i < vector_size(entries); i++) {
+    section = entries[i];
+    uci_emit_open(emit, NULL, '{');
+    uci_emit_leaf(emit, "\"firstname\": ", section, "firstname", 0);
+    uci_emit_leaf(emit, "\"lastname\": ", section, "lastname", 0);
+    uci_emit_leaf(emit, "\"age\": ", section, "age", 1);
+    uci_emit_leaf(emit, "\"major\": ", section, "major", 0);
+    uci_emit_leaf(emit, "\"grade\": ", section, "grade", 1);
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  if (entries) {
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  vector_free(entries);
+}
+
+static void emit_restconf_example_course_instructor(struct UciEmit *emit, const char *key, const struct UciMapSection *section, int flags) {
+  if (!(section = uci_emit_section(emit, "instructor"))) {
+    return;
+  }
+  uci_emit_open(emit, key, '{');
+  uci_emit_leaf(emit, "\"name\": ", section, "name", 0);
+  uci_emit_leaf(emit, "\"email\": ", section, "email", 0);
+  uci_emit_close(emit, flags);
+}
+
+static void emit_restconf_example_building_offices(struct UciEmit *emit, const char *key, const struct UciMapSection *section, int flags) {
+  const struct UciMapSection **entries = uci_emit_list_open(emit, key, "office", flags);
+  for (size_t i = 0; i < vector_size(entries); i++) {
+    section = entries[i];
+    uci_emit_open(emit, NULL, '{');
+    uci_emit_leaf(emit, "\"number\": ", section, "number", 0);
+    uci_emit_leaf(emit, "\"occupant\": ", section, "occupant", 0);
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  if (entries) {
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  vector_free(entries);
+}
+
+static void emit_restconf_example_building_labs(struct UciEmit *emit, const char *key, const struct UciMapSection *section, int flags) {
+  const struct UciMapSection **entries = uci_emit_list_open(emit, key, "lab", flags);
+  for (size_t i = 0; i < vector_size(entries); i++) {
+    section = entries[i];
+    uci_emit_open(emit, NULL, '{');
+    uci_emit_leaf(emit, "\"wing\": ", section, "wing", 0);
+    uci_emit_leaf(emit, "\"number\": ", section, "number", 0);
+    uci_emit_leaf(emit, "\"subject\": ", section, "subject", 0);
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  if (entries) {
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  vector_free(entries);
+}
+
+static void emit_restconf_example_rooms(struct UciEmit *emit, const char *key, const struct UciMapSection *section, int flags) {
+  const struct UciMapSection **entries = uci_emit_list_open(emit, key, "room", flags);
+  for (size_t i = 0; i < vector_size(entries); i++) {
+    section = entries[i];
+    uci_emit_open(emit, NULL, '{');
+    uci_emit_leaf(emit, "\"number\": ", section, "number", 0);
+    uci_emit_leaf(emit, "\"seats\": ", section, "seats", 1);
+    uci_emit_leaf(emit, "\"projectors\": ", section, "projectors", 1);
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  if (entries) {
+    uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  vector_free(entries);
+}
+
+static const map_str2emitter emittermap[] = {
+    {"restconf-example", "course/students", emit_restconf_example_course_students},
+    {"restconf-example", "course/instructor", emit_restconf_example_course_instructor},
+    {"restconf-example", "building/offices", emit_restconf_example_building_offices},
+    {"restconf-example", "building/labs", emit_restconf_example_building_labs},
+    {"restconf-example", "rooms", emit_restconf_example_rooms},
+    {NULL, NULL, NULL}
+};
+
+/**
+ * Get the generated emitter of a container or list
+ * @param module name of the module
+ * @param path the names of the nodes from the top-level node separated by '/'
+ * @return the emitter or NULL if the node has to be read by the generic walk
+ */
+yang_emitter yang_emitter_for(const char *module, const char *path) {
+  for (const map_str2emitter *iter = emittermap; iter->module; iter++) {
+    if (strcmp(module, iter->module) == 0 && strcmp(path, iter->path) == 0) {
+      return iter->emitter;
+    }
+  }
+  return NULL;
+}
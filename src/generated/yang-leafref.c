@@ -0,0 +1,14 @@
+#include <stddef.h>
+#include "generated/yang.h"
+#include "leafref.h"
+
+static const struct YangLeafref leafrefs[] = {
+    {{"restconf-example", NULL, "course", "room"}, {"restconf-example", "room", NULL, "number"}},
+    {{NULL, NULL, NULL, NULL}, {NULL, NULL, NULL, NULL}}
+};
+
+/**
+ * Get the leafrefs of all modules
+ * @return the leafrefs, terminated by one without package
+ */
+const struct YangLeafref *yang_leafrefs() { return leafrefs; }
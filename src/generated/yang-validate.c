@@ -0,0 +1,189 @@
+#include <stdint.h>
+#include "generated/yang.h"
+#include "yang-verify.h"
+
+static struct YangPattern pattern_0 = INIT_YANG_PATTERN("^(CS|IMS)$");
+static struct YangPattern pattern_1 = INIT_YANG_PATTERN("^[A-Za-z0-9]*@university.de$");
+static struct YangPattern pattern_2 = INIT_YANG_PATTERN("^O[0-9]+$");
+static struct YangPattern pattern_3 = INIT_YANG_PATTERN("^[A-Z][0-9]+$");
+
+static const char *const names_0_slots[] = {
+    "renovation",
+    "open",
+    NULL,
+    NULL,
+    NULL,
+    "closed",
+    NULL,
+    NULL
+};
+static const struct YangNameSet names_0 = {names_0_slots, 8, 2166136261u};
+
+static const char *const names_1_slots[] = {
+    NULL,
+    NULL,
+    "students",
+    "guests",
+    "staff",
+    NULL,
+    NULL,
+    NULL
+};
+static const struct YangNameSet names_1 = {names_1_slots, 8, 2166136262u};
+
+static const char *const names_2_slots[] = {
+    "laboratory",
+    NULL,
+    NULL,
+    "lecture-hall"
+};
+static const struct YangNameSet names_2 = {names_2_slots, 4, 2166136261u};
+
+static const char *const names_3_slots[] = {
+    NULL,
+    "unknown"
+};
+static const struct YangNameSet names_3 = {names_3_slots, 2, 2166136261u};
+
+static int verify_restconf_example_course_name(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_course_semester(const char *value) {
+  return yang_verify_integer(value, 1, 6);
+}
+
+static int verify_restconf_example_course_instructors(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_course_students_firstname(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_course_students_lastname(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_course_students_age(const char *value) {
+  return yang_verify_integer(value, 0, 120);
+}
+
+static int verify_restconf_example_course_students_major(const char *value) {
+  return yang_verify_pattern(&pattern_0, value);
+}
+
+static int verify_restconf_example_course_students_grade(const char *value) {
+  return yang_verify_integer(value, 0, 100);
+}
+
+static int verify_restconf_example_course_instructor_name(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_course_instructor_email(const char *value) {
+  return yang_verify_pattern(&pattern_1, value);
+}
+
+static int verify_restconf_example_building_status(const char *value) {
+  return yang_verify_enum(&names_0, value);
+}
+
+static int verify_restconf_example_building_access(const char *value) {
+  return yang_verify_bits(&names_1, value);
+}
+
+static int verify_restconf_example_building_kind(const char *value) {
+  return yang_verify_identity(&names_2, value);
+}
+
+static int verify_restconf_example_building_floors(const char *value) {
+  return (yang_verify_integer(value, 1, 20)) &&
+         (yang_verify_enum(&names_3, value));
+}
+
+static int verify_restconf_example_building_offices_number(const char *value) {
+  return yang_verify_pattern(&pattern_2, value);
+}
+
+static int verify_restconf_example_building_offices_occupant(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_building_labs_wing(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_building_labs_number(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_building_labs_subject(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_campus(const char *value) {
+  (void)value;
+  return 0;
+}
+
+static int verify_restconf_example_rooms_number(const char *value) {
+  return yang_verify_pattern(&pattern_3, value);
+}
+
+static int verify_restconf_example_rooms_seats(const char *value) {
+  return yang_verify_integer(value, 0, 65535);
+}
+
+static int verify_restconf_example_rooms_projectors(const char *value) {
+  return yang_verify_integer(value, 0, 255);
+}
+
+static const yang_validator validatormap[] = {
+    verify_restconf_example_course_name,
+    verify_restconf_example_course_semester,
+    verify_restconf_example_course_instructors,
+    verify_restconf_example_course_students_firstname,
+    verify_restconf_example_course_students_lastname,
+    verify_restconf_example_course_students_age,
+    verify_restconf_example_course_students_major,
+    verify_restconf_example_course_students_grade,
+    verify_restconf_example_course_instructor_name,
+    verify_restconf_example_course_instructor_email,
+    verify_restconf_example_building_status,
+    verify_restconf_example_building_access,
+    verify_restconf_example_building_kind,
+    verify_restconf_example_building_floors,
+    verify_restconf_example_building_offices_number,
+    verify_restconf_example_building_offices_occupant,
+    verify_restconf_example_building_labs_wing,
+    verify_restconf_example_building_labs_number,
+    verify_restconf_example_building_labs_subject,
+    verify_restconf_example_campus,
+    verify_restconf_example_rooms_number,
+    verify_restconf_example_rooms_seats,
+    verify_restconf_example_rooms_projectors,
+    NULL
+};
+
+/**
+ * Get the compiled validator of a leaf
+ * @param index the index stored in the "verify" field of the leaf
+ * @return the validator or NULL if the index is invalid
+ */
+yang_validator yang_validator_at(int index) {
+  if (index < 0 ||
+      index >= (int)(sizeof(validatormap) / sizeof(validatormap[0]))) {
+    return NULL;
+  }
+  return validatormap[index];
+}
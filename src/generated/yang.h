@@ -12,7 +12,7 @@ struct map_str2str{
 typedef struct map_str2str map_str2str;
 
 static const map_str2str modulemap[] = {
-    {"restconf-example", "{\"type\": \"module\", \"map\": {\"course\": {\"type\": \"container\", \"map\": {\"name\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"name\", \"leaf-type\": \"string\"}, \"semester\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"semester\", \"leaf-type\": {\"leaf-type\": \"uint8\", \"from\": \"1\", \"to\": \"6\"}}, \"instructors\": {\"type\": \"leaf-list\", \"map\": {}, \"option\": \"instructors\", \"leaf-type\": \"string\"}, \"students\": {\"type\": \"list\", \"map\": {\"firstname\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"firstname\", \"leaf-type\": \"string\"}, \"lastname\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"lastname\", \"leaf-type\": \"string\"}, \"age\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"age\", \"leaf-type\": {\"leaf-type\": \"uint8\", \"from\": \"0\", \"to\": \"120\"}}, \"major\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"major\", \"leaf-type\": {\"leaf-type\": \"string\", \"pattern\": \"^(CS|IMS)$\"}}, \"grade\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"grade\", \"leaf-type\": \"grade\"}}, \"section\": \"student\", \"leaf-as-name\": \"lastname\", \"keys\": [\"firstname\", \"lastname\", \"age\"]}, \"instructor\": {\"type\": \"container\", \"map\": {\"name\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"name\", \"leaf-type\": \"string\"}, \"email\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"email\", \"leaf-type\": \"email\"}}, \"section-name\": \"instructor\", \"section\": \"instructor\"}}, \"section-name\": \"course\", \"section\": \"course\"}}, \"package\": \"restconf-example\"}"}
+    {"restconf-example", "{\"type\": \"module\", \"map\": {\"course\": {\"type\": \"container\", \"map\": {\"name\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"name\", \"leaf-type\": \"string\", \"verify\": 0}, \"semester\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"semester\", \"leaf-type\": {\"leaf-type\": \"uint8\", \"from\": \"1\", \"to\": \"6\"}, \"verify\": 1}, \"room\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"room\", \"leaf-type\": {\"leaf-type\": \"leafref\", \"path\": \"/ex:rooms/ex:number\"}}, \"instructors\": {\"type\": \"leaf-list\", \"map\": {}, \"option\": \"instructors\", \"leaf-type\": \"string\", \"verify\": 2}, \"students\": {\"type\": \"list\", \"map\": {\"firstname\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"firstname\", \"leaf-type\": \"string\", \"verify\": 3}, \"lastname\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"lastname\", \"leaf-type\": \"string\", \"verify\": 4}, \"age\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"age\", \"leaf-type\": {\"leaf-type\": \"uint8\", \"from\": \"0\", \"to\": \"120\"}, \"verify\": 5}, \"major\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"major\", \"leaf-type\": {\"leaf-type\": \"string\", \"pattern\": \"^(CS|IMS)$\"}, \"verify\": 6}, \"grade\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"grade\", \"leaf-type\": \"grade\", \"verify\": 7}}, \"section\": \"student\", \"leaf-as-name\": \"lastname\", \"keys\": [\"firstname\", \"lastname\", \"age\"]}, \"instructor\": {\"type\": \"container\", \"map\": {\"name\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"name\", \"leaf-type\": \"string\", \"verify\": 8}, \"email\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"email\", \"leaf-type\": \"email\", \"verify\": 9}}, \"section-name\": \"instructor\", \"section\": \"instructor\"}}, \"section-name\": \"course\", \"section\": \"course\"}, \"building\": {\"type\": \"container\", \"map\": {\"status\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"status\", \"leaf-type\": {\"leaf-type\": \"enumeration\", \"enum\": [\"open\", \"closed\", \"renovation\"]}, \"verify\": 10}, \"access\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"access\", \"leaf-type\": {\"leaf-type\": \"bits\", \"bit\": [\"students\", \"staff\", \"guests\"]}, \"verify\": 11}, \"kind\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"kind\", \"leaf-type\": {\"leaf-type\": \"identityref\", \"base\": \"building-kind\"}, \"verify\": 12}, \"floors\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"floors\", \"leaf-type\": {\"leaf-type\": \"union\", \"types\": [{\"leaf-type\": \"uint8\", \"from\": \"1\", \"to\": \"20\"}, {\"leaf-type\": \"enumeration\", \"enum\": [\"unknown\"]}]}, \"verify\": 13}, \"offices\": {\"type\": \"list\", \"map\": {\"number\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"number\", \"leaf-type\": {\"leaf-type\": \"string\", \"pattern\": \"^O[0-9]+$\"}, \"verify\": 14}, \"occupant\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"occupant\", \"leaf-type\": \"string\", \"verify\": 15}}, \"section\": \"office\", \"leaf-as-name\": \"number\", \"keys\": [\"number\"]}, \"labs\": {\"type\": \"list\", \"map\": {\"wing\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"wing\", \"leaf-type\": \"string\", \"verify\": 16}, \"number\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"number\", \"leaf-type\": \"string\", \"verify\": 17}, \"subject\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"subject\", \"leaf-type\": \"string\", \"verify\": 18}}, \"section\": \"lab\", \"key-hash-name\": \"lab\", \"keys\": [\"wing\", \"number\"]}}, \"section-name\": \"building\", \"section\": \"building\"}, \"campus\": {\"type\": \"leaf\", \"map\": {}, \"section-name\": \"settings\", \"section\": \"settings\", \"option\": \"campus\", \"leaf-type\": \"string\", \"verify\": 19}, \"rooms\": {\"type\": \"list\", \"map\": {\"number\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"number\", \"leaf-type\": {\"leaf-type\": \"string\", \"pattern\": \"^[A-Z][0-9]+$\"}, \"verify\": 20}, \"seats\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"seats\", \"leaf-type\": \"uint16\", \"verify\": 21}, \"projectors\": {\"type\": \"leaf\", \"map\": {}, \"option\": \"projectors\", \"leaf-type\": \"uint8\", \"verify\": 22}}, \"section\": \"room\", \"leaf-as-name\": \"number\", \"keys\": [\"number\"]}}, \"package\": \"restconf-example\"}"}
 };
 
 static const map_str2str yang2regex[] = {
@@ -62,11 +62,29 @@ static const map_str2yang_type str2yang_type[] = {
     {"uint64", UINT_64},
     {"binary", BINARY},
     {"boolean", BOOLEAN},
-    {"decimal64", DECIMAL_64}
+    {"decimal64", DECIMAL_64},
+    {"enumeration", ENUMERATION},
+    {"bits", BITS},
+    {"identityref", IDENTITY_REF},
+    {"leafref", LEAF_REF},
+    {"union", UNION}
 };
 
+struct UciEmit;
+struct UciMapSection;
+struct YangConstraints;
+struct YangLeafref;
+typedef void (*yang_emitter)(struct UciEmit* emit, const char* key,
+                             const struct UciMapSection* section,
+                             int flags);
+typedef int (*yang_validator)(const char* value);
+
 struct json_object* yang_module_exists(char* module);
 yang_type str_to_yang_type(const char* str);
 const char* yang_for_type(const char* type);
+yang_emitter yang_emitter_for(const char* module, const char* path);
+yang_validator yang_validator_at(int index);
+const struct YangConstraints* yang_constraints();
+const struct YangLeafref* yang_leafrefs();
 
 #endif
\ No newline at end of file
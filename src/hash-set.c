@@ -0,0 +1,118 @@
+#include "hash-set.h"
+#include <stdlib.h>
+#include <string.h>
+#include "util.h"
+#include "vector.h"
+
+/**
+ * @brief FNV-1a hash of a string
+ * @param key the string to be hashed
+ * @return the hash
+ */
+size_t hash_string(const char *key) {
+  size_t hash = 2166136261u;
+  while (*key) {
+    hash ^= (unsigned char)*key++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * @brief find the bucket of a key
+ * @param set the set to be searched
+ * @param key the key
+ * @return the bucket holding the key or the empty bucket it belongs in
+ */
+static size_t find_bucket(const struct HashSet *set, const char *key) {
+  size_t mask = set->capacity - 1;
+  size_t bucket = hash_string(key) & mask;
+  while (set->buckets[bucket] &&
+         strcmp(set->items[set->buckets[bucket] - 1], key) != 0) {
+    bucket = (bucket + 1) & mask;
+  }
+  return bucket;
+}
+
+/**
+ * @brief grow the bucket table and rehash all keys
+ * @param set the set to be grown
+ * @return 0 if success else 1
+ */
+static int grow(struct HashSet *set) {
+  size_t capacity = set->capacity ? set->capacity * 2 : 16;
+  size_t *buckets = calloc(capacity, sizeof(size_t));
+  if (!buckets) {
+    return 1;
+  }
+  free(set->buckets);
+  set->buckets = buckets;
+  set->capacity = capacity;
+  for (size_t i = 0; i < vector_size(set->items); i++) {
+    set->buckets[find_bucket(set, set->items[i])] = i + 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief add a key to the set
+ * @param set the set
+ * @param key the key to be copied into the request arena
+ * @return 1 if added, 0 if already present and -1 on error
+ */
+int hash_set_add(struct HashSet *set, const char *key) {
+  size_t bucket;
+  char *copy = NULL;
+  // keep the load factor at or below one half
+  if ((vector_size(set->items) + 1) * 2 > set->capacity && grow(set)) {
+    return -1;
+  }
+  bucket = find_bucket(set, key);
+  if (set->buckets[bucket]) {
+    return 0;
+  }
+  if (!(copy = str_dup(key))) {
+    return -1;
+  }
+  vector_push_back(set->items, copy);
+  set->buckets[bucket] = vector_size(set->items);
+  return 1;
+}
+
+/**
+ * @brief check if a key is in the set
+ * @param set the set
+ * @param key the key
+ * @return 1 if present else 0
+ */
+int hash_set_contains(const struct HashSet *set, const char *key) {
+  if (!set->capacity) {
+    return 0;
+  }
+  return set->buckets[find_bucket(set, key)] != 0;
+}
+
+/**
+ * @brief find the position of a key in insertion order
+ * @param set the set
+ * @param key the key
+ * @return the position or -1 if not present
+ */
+long hash_set_find(const struct HashSet *set, const char *key) {
+  if (!set->capacity) {
+    return -1;
+  }
+  return (long)set->buckets[find_bucket(set, key)] - 1;
+}
+
+/**
+ * @brief free the set itself, the keys live in the request arena
+ * @param set the set to be freed
+ */
+void hash_set_free(struct HashSet *set) {
+  vector_free(set->items);
+  free(set->buckets);
+  set->items = NULL;
+  set->buckets = NULL;
+  set->capacity = 0;
+}
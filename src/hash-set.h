@@ -0,0 +1,25 @@
+#ifndef RESTCONF_HASH_SET_H
+#define RESTCONF_HASH_SET_H
+
+#include <stddef.h>
+
+/**
+ * A set of strings with open addressing
+ * The keys are copied and kept in insertion order in the items vector.
+ */
+struct HashSet {
+  char **items;
+  size_t *buckets;
+  size_t capacity;
+};
+
+#define INIT_HASH_SET() \
+  { NULL, NULL, 0 }
+
+size_t hash_string(const char *key);
+int hash_set_add(struct HashSet *set, const char *key);
+int hash_set_contains(const struct HashSet *set, const char *key);
+long hash_set_find(const struct HashSet *set, const char *key);
+void hash_set_free(struct HashSet *set);
+
+#endif  // RESTCONF_HASH_SET_H
@@ -1,24 +1,6 @@
 #include "http.h"
 #include <stdio.h>
 #include <string.h>
-#include "vector.h"
-
-/**
- * @brief splits path into fields
- *
- * @param path the path to be split
- * @param identifier the identifier to split
- * @return char** vector of strings
- */
-char **path2vec(char *path, char *identifier) {
-  char **vec = NULL;
-  char *token = strtok(path, identifier);
-  while (token != NULL) {
-    vector_push_back(vec, token);
-    token = strtok(NULL, identifier);
-  }
-  return vec;
-}
 
 /**
  * @brief HTTP error 400
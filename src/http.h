@@ -14,7 +14,6 @@ int not_implemented(struct CgiContext *ctx);
 void content_type_json();
 void headers_end();
 
-char **path2vec(char *path, char *identifier);
 
 int is_GET(const char* method);
 int is_OPTIONS(const char* method);
@@ -0,0 +1,27 @@
+#include "intern.h"
+#include "hash-set.h"
+
+/**
+ * The names interned while the request is handled, they live in the request
+ * arena
+ */
+static struct HashSet symbols = INIT_HASH_SET();
+
+/**
+ * @brief get the unique copy of a name
+ * Equal names are interned to the same pointer, so interned names can be
+ * compared and hashed by address.
+ * @param name the name
+ * @return the interned name or NULL on error
+ */
+char *intern(const char *name) {
+  if (hash_set_add(&symbols, name) < 0) {
+    return NULL;
+  }
+  return symbols.items[hash_set_find(&symbols, name)];
+}
+
+/**
+ * @brief free the symbol table, the names are released with the request arena
+ */
+void intern_release() { hash_set_free(&symbols); }
@@ -0,0 +1,7 @@
+#ifndef RESTCONF_INTERN_H
+#define RESTCONF_INTERN_H
+
+char *intern(const char *name);
+void intern_release();
+
+#endif  // RESTCONF_INTERN_H
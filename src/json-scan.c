@@ -0,0 +1,266 @@
+#include "json-scan.h"
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief check if a byte ends a run of plain string content
+ * @param c the byte
+ * @param ascii_only if set bytes above 0x7F end the run as well
+ * @return 1 for quotes, backslashes and control characters else 0
+ */
+static int is_string_special(unsigned char c, int ascii_only) {
+  return c == '"' || c == '\\' || c < 0x20 || (ascii_only && c > 0x7F);
+}
+
+/**
+ * @brief count the bytes of plain string content one byte at a time
+ * @param data the bytes
+ * @param length the number of bytes
+ * @param ascii_only if set bytes above 0x7F end the run as well
+ * @return the number of bytes before the first special byte
+ */
+static size_t scan_plain_scalar(const char *data, size_t length,
+                                int ascii_only) {
+  size_t i = 0;
+  while (i < length && !is_string_special((unsigned char)data[i], ascii_only)) {
+    i++;
+  }
+  return i;
+}
+
+/**
+ * @brief count the bytes of plain JSON string content
+ * Plain content needs no escaping, so the tokenizer and the writer copy such
+ * runs as a whole. Quotes, backslashes and control characters are looked
+ * for in blocks of 16 or 32 bytes where the target supports it.
+ * @param data the bytes
+ * @param length the number of bytes
+ * @param ascii_only if set bytes above 0x7F end the run as well
+ * @return the number of bytes before the first special byte
+ */
+size_t json_scan_plain(const char *data, size_t length, int ascii_only) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1F);
+  for (; i + 32 <= length; i += 32) {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(data + i));
+    // unsigned bytes up to 0x1F are unchanged by the minimum with 0x1F
+    __m256i special = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(block, quote),
+                        _mm256_cmpeq_epi8(block, backslash)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(block, control), block));
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(special);
+    if (ascii_only) {
+      mask |= (unsigned int)_mm256_movemask_epi8(block);
+    }
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i quote16 = _mm_set1_epi8('"');
+  const __m128i backslash16 = _mm_set1_epi8('\\');
+  const __m128i control16 = _mm_set1_epi8(0x1F);
+  for (; i + 16 <= length; i += 16) {
+    __m128i block = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(block, quote16),
+                     _mm_cmpeq_epi8(block, backslash16)),
+        _mm_cmpeq_epi8(_mm_min_epu8(block, control16), block));
+    int mask = _mm_movemask_epi8(special);
+    if (ascii_only) {
+      mask |= _mm_movemask_epi8(block);
+    }
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const uint8x16_t quote16 = vdupq_n_u8('"');
+  const uint8x16_t backslash16 = vdupq_n_u8('\\');
+  const uint8x16_t control16 = vdupq_n_u8(0x1F);
+  const uint8x16_t ascii16 = vdupq_n_u8(ascii_only ? 0x7F : 0xFF);
+  for (; i + 16 <= length; i += 16) {
+    uint8x16_t block = vld1q_u8((const uint8_t *)(data + i));
+    uint8x16_t special = vorrq_u8(
+        vorrq_u8(vceqq_u8(block, quote16), vceqq_u8(block, backslash16)),
+        vorrq_u8(vcleq_u8(block, control16), vcgtq_u8(block, ascii16)));
+    if (vmaxvq_u8(special)) {
+      break;
+    }
+  }
+#endif
+  return i + scan_plain_scalar(data + i, length - i, ascii_only);
+}
+
+#define JSON_SCAN_BLOCK 64
+
+/**
+ * @brief mark the bytes of a block that are one of a set of characters
+ * @param block the 64 bytes of the block
+ * @param set the characters
+ * @return a mask with bit i set if byte i is in the set
+ */
+static uint64_t match_block(const char *block, const char *set) {
+  uint64_t mask = 0;
+#if defined(__AVX2__)
+  for (int i = 0; i < JSON_SCAN_BLOCK; i += 32) {
+    __m256i bytes = _mm256_loadu_si256((const __m256i *)(block + i));
+    __m256i found = _mm256_setzero_si256();
+    for (const char *c = set; *c; c++) {
+      found = _mm256_or_si256(found,
+                              _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(*c)));
+    }
+    mask |= (uint64_t)(uint32_t)_mm256_movemask_epi8(found) << i;
+  }
+#elif defined(__SSE2__)
+  for (int i = 0; i < JSON_SCAN_BLOCK; i += 16) {
+    __m128i bytes = _mm_loadu_si128((const __m128i *)(block + i));
+    __m128i found = _mm_setzero_si128();
+    for (const char *c = set; *c; c++) {
+      found = _mm_or_si128(found, _mm_cmpeq_epi8(bytes, _mm_set1_epi8(*c)));
+    }
+    mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(found) << i;
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                      1, 2, 4, 8, 16, 32, 64, 128};
+  const uint8x16_t weight = vld1q_u8(weights);
+  uint8x16_t parts[4];
+  for (int i = 0; i < 4; i++) {
+    uint8x16_t bytes = vld1q_u8((const uint8_t *)(block + i * 16));
+    uint8x16_t found = vdupq_n_u8(0);
+    for (const char *c = set; *c; c++) {
+      found = vorrq_u8(found, vceqq_u8(bytes, vdupq_n_u8((uint8_t)*c)));
+    }
+    parts[i] = vandq_u8(found, weight);
+  }
+  // adding neighbouring lanes three times packs each 8 lanes into one byte
+  uint8x16_t sum = vpaddq_u8(vpaddq_u8(parts[0], parts[1]),
+                             vpaddq_u8(parts[2], parts[3]));
+  sum = vpaddq_u8(sum, sum);
+  mask = vgetq_lane_u64(vreinterpretq_u64_u8(sum), 0);
+#else
+  for (int i = 0; i < JSON_SCAN_BLOCK; i++) {
+    for (const char *c = set; *c; c++) {
+      if (block[i] == *c) {
+        mask |= (uint64_t)1 << i;
+        break;
+      }
+    }
+  }
+#endif
+  return mask;
+}
+
+/**
+ * @brief set every bit that has an odd number of set bits at or below it
+ * @param bits the bits
+ * @return the running parity
+ */
+static uint64_t prefix_xor(uint64_t bits) {
+  for (int shift = 1; shift < JSON_SCAN_BLOCK; shift <<= 1) {
+    bits ^= bits << shift;
+  }
+  return bits;
+}
+
+/**
+ * @brief mark the bytes that follow an unescaped backslash
+ * Backslashes are rare, so they are walked one by one.
+ * @param backslash the backslashes of the block
+ * @param count the number of bytes of the block
+ * @param state the carry of the previous block, updated for the next one
+ * @return the escaped bytes
+ */
+static uint64_t escaped_block(uint64_t backslash, int count,
+                              struct JsonScanState *state) {
+  uint64_t escaped = state->escaped ? 1 : 0;
+  state->escaped = 0;
+  for (; backslash; backslash &= backslash - 1) {
+    int i = __builtin_ctzll(backslash);
+    if (escaped & ((uint64_t)1 << i)) {
+      continue;
+    }
+    if (i + 1 == count) {
+      state->escaped = 1;
+    } else {
+      escaped |= (uint64_t)1 << (i + 1);
+    }
+  }
+  return escaped;
+}
+
+/**
+ * @brief find the structural bytes of one block
+ * @param block the 64 bytes of the block, bytes past count are spaces
+ * @param count the number of bytes of the block
+ * @param state the carry of the previous block, updated for the next one
+ * @return the mask of the structural bytes
+ */
+static uint64_t structurals_block(const char *block, int count,
+                                  struct JsonScanState *state) {
+  uint64_t valid = count == JSON_SCAN_BLOCK ? ~(uint64_t)0
+                                            : ((uint64_t)1 << count) - 1;
+  uint64_t escaped = escaped_block(match_block(block, "\\"), count, state);
+  uint64_t quote = match_block(block, "\"") & ~escaped;
+  // a string runs from its opening quote up to its closing quote
+  uint64_t in_string = prefix_xor(quote) ^ state->in_string;
+  uint64_t outside = ~in_string;
+  uint64_t op = match_block(block, "{}[]:,") & outside;
+  uint64_t space = match_block(block, " \t\n\r") & outside;
+  // closing quotes are neither operators nor whitespace, nor a scalar start
+  uint64_t scalar = outside & ~op & ~space & ~quote;
+  uint64_t follows_scalar = (scalar << 1) | (state->scalar ? 1 : 0);
+
+  state->in_string = (in_string >> (count - 1)) & 1 ? ~(uint64_t)0 : 0;
+  state->scalar = (scalar >> (count - 1)) & 1;
+  return (op | (quote & in_string) | (scalar & ~follows_scalar)) & valid;
+}
+
+/**
+ * @brief index the structural bytes of a chunk of JSON text
+ * Operators, opening quotes and the first byte of numbers and literals are
+ * structural, so a tokenizer can go from one token to the next without
+ * looking at the whitespace and string content in between. Quotes,
+ * backslashes, operators and whitespace are classified 64 bytes at a time.
+ * The state carries strings, escapes and scalars that continue in the next
+ * chunk.
+ * @param data the bytes
+ * @param length the number of bytes
+ * @param state the state after the previous chunk
+ * @param indexes filled with the offsets of the structural bytes, it has room
+ * for length offsets
+ * @return the number of structural bytes
+ */
+size_t json_scan_structurals(const char *data, size_t length,
+                             struct JsonScanState *state,
+                             unsigned int *indexes) {
+  size_t count = 0;
+  for (size_t offset = 0; offset < length; offset += JSON_SCAN_BLOCK) {
+    char padded[JSON_SCAN_BLOCK];
+    const char *block = data + offset;
+    int size = length - offset < JSON_SCAN_BLOCK ? (int)(length - offset)
+                                                 : JSON_SCAN_BLOCK;
+    uint64_t structurals;
+    if (size < JSON_SCAN_BLOCK) {
+      memset(padded, ' ', sizeof(padded));
+      memcpy(padded, block, size);
+      block = padded;
+    }
+    structurals = structurals_block(block, size, state);
+    for (; structurals; structurals &= structurals - 1) {
+      indexes[count++] = (unsigned int)(offset + __builtin_ctzll(structurals));
+    }
+  }
+  return count;
+}
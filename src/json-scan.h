@@ -0,0 +1,28 @@
+#ifndef RESTCONF_JSON_SCAN_H
+#define RESTCONF_JSON_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * What the structural index carries from the end of one block of input into
+ * the next
+ */
+struct JsonScanState {
+  // all bits set if the last byte was inside a string
+  uint64_t in_string;
+  // the last byte was an unescaped backslash
+  int escaped;
+  // the last byte was part of a number or literal
+  int scalar;
+};
+
+#define INIT_JSON_SCAN_STATE() \
+  { 0, 0, 0 }
+
+size_t json_scan_plain(const char *data, size_t length, int ascii_only);
+size_t json_scan_structurals(const char *data, size_t length,
+                             struct JsonScanState *state,
+                             unsigned int *indexes);
+
+#endif  // RESTCONF_JSON_SCAN_H
@@ -0,0 +1,414 @@
+#include "json-stream.h"
+#include <string.h>
+#include "json-scan.h"
+#include "vector.h"
+
+/**
+ * @brief read the next chunk of the input into the buffer
+ * @param stream the stream
+ * @return the number of bytes read, 0 at the end of the input
+ */
+static size_t fill_buffer(struct JsonStream *stream) {
+  size_t wanted = stream->remaining < sizeof(stream->buffer)
+                      ? stream->remaining
+                      : sizeof(stream->buffer);
+  size_t read = wanted ? fread(stream->buffer, sizeof(char), wanted,
+                               stream->in)
+                       : 0;
+  if (!read) {
+    stream->remaining = 0;
+  } else {
+    stream->remaining -= read;
+  }
+  stream->position = 0;
+  stream->length = read;
+  stream->structural_count = json_scan_structurals(
+      stream->buffer, read, &stream->scan, stream->structurals);
+  stream->next_structural = 0;
+  return read;
+}
+
+/**
+ * @brief read the next character of the input
+ * @param stream the stream
+ * @return the character or EOF at the end of the input
+ */
+static int read_char(struct JsonStream *stream) {
+  if (stream->position == stream->length && !fill_buffer(stream)) {
+    return EOF;
+  }
+  return (unsigned char)stream->buffer[stream->position++];
+}
+
+/**
+ * @brief push the character that was just read back so it is read again
+ * @param stream the stream
+ * @param c the character
+ */
+static void unread_char(struct JsonStream *stream, int c) {
+  if (c != EOF) {
+    stream->position--;
+  }
+}
+
+/**
+ * @brief read the first character of the next token
+ * Everything between the end of the last token and the next structural byte
+ * is whitespace, so it is skipped without being looked at.
+ * @param stream the stream
+ * @return the character or EOF at the end of the input
+ */
+static int read_structural(struct JsonStream *stream) {
+  while (1) {
+    while (stream->next_structural < stream->structural_count) {
+      size_t index = stream->structurals[stream->next_structural++];
+      // structural bytes inside the last token were read with it
+      if (index >= stream->position) {
+        stream->position = index;
+        return read_char(stream);
+      }
+    }
+    if (!fill_buffer(stream)) {
+      return EOF;
+    }
+  }
+}
+
+/**
+ * @brief check if a character can follow a number or literal
+ * @param c the character
+ * @return 1 for whitespace, operators and the end of the input else 0
+ */
+static int ends_scalar(int c) {
+  return c == EOF || c == ' ' || c == '\t' || c == '\n' || c == '\r' ||
+         c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+/**
+ * @brief append bytes to the text of the current token
+ * @param stream the stream
+ * @param bytes the bytes
+ * @param count the number of bytes
+ */
+static void append_bytes(struct JsonStream *stream, const char *bytes,
+                         size_t count) {
+  size_t size = vector_size(stream->text);
+  size_t needed = size + count;
+  if (!count) {
+    return;
+  }
+  if (vector_capacity(stream->text) < needed) {
+    size_t capacity = vector_capacity(stream->text) * 2;
+    vector_grow(stream->text, capacity < needed ? needed : capacity);
+  }
+  memcpy(stream->text + size, bytes, count);
+  vector_set_size(stream->text, size + count);
+}
+
+/**
+ * @brief append a byte to the text of the current token
+ * @param stream the stream
+ * @param c the byte
+ */
+static void append_char(struct JsonStream *stream, char c) {
+  vector_push_back(stream->text, c);
+}
+
+/**
+ * @brief terminate the text of the current token
+ * @param stream the stream
+ */
+static void terminate_text(struct JsonStream *stream) {
+  append_char(stream, '\0');
+}
+
+/**
+ * @brief read the four hex digits of an \\u escape
+ * @param stream the stream
+ * @return the code unit or -1 on error
+ */
+static long read_hex4(struct JsonStream *stream) {
+  long unit = 0;
+  for (int i = 0; i < 4; i++) {
+    int c = read_char(stream);
+    unit <<= 4;
+    if (c >= '0' && c <= '9') {
+      unit |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      unit |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      unit |= c - 'A' + 10;
+    } else {
+      return -1;
+    }
+  }
+  return unit;
+}
+
+/**
+ * @brief append a code point encoded as UTF-8
+ * @param stream the stream
+ * @param code the code point
+ */
+static void append_utf8(struct JsonStream *stream, long code) {
+  if (code < 0x80) {
+    append_char(stream, (char)code);
+  } else if (code < 0x800) {
+    append_char(stream, (char)(0xC0 | (code >> 6)));
+    append_char(stream, (char)(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    append_char(stream, (char)(0xE0 | (code >> 12)));
+    append_char(stream, (char)(0x80 | ((code >> 6) & 0x3F)));
+    append_char(stream, (char)(0x80 | (code & 0x3F)));
+  } else {
+    append_char(stream, (char)(0xF0 | (code >> 18)));
+    append_char(stream, (char)(0x80 | ((code >> 12) & 0x3F)));
+    append_char(stream, (char)(0x80 | ((code >> 6) & 0x3F)));
+    append_char(stream, (char)(0x80 | (code & 0x3F)));
+  }
+}
+
+/**
+ * @brief read an \\u escape including a following low surrogate
+ * @param stream the stream
+ * @return 0 on success else 1
+ */
+static int read_unicode_escape(struct JsonStream *stream) {
+  long code = read_hex4(stream);
+  if (code <= 0 || (code >= 0xDC00 && code <= 0xDFFF)) {
+    // NUL cannot be part of a C string and low surrogates must come second
+    return 1;
+  }
+  if (code >= 0xD800 && code <= 0xDBFF) {
+    long low;
+    if (read_char(stream) != '\\' || read_char(stream) != 'u') {
+      return 1;
+    }
+    low = read_hex4(stream);
+    if (low < 0xDC00 || low > 0xDFFF) {
+      return 1;
+    }
+    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+  }
+  append_utf8(stream, code);
+  return 0;
+}
+
+/**
+ * @brief read a string token after its opening quote
+ * Runs of plain content are copied from the buffer as a whole.
+ * @param stream the stream
+ * @return JSON_TOKEN_STRING or JSON_TOKEN_ERROR
+ */
+static enum json_token read_string(struct JsonStream *stream) {
+  int c;
+  while (1) {
+    size_t run;
+    if (stream->position == stream->length && !fill_buffer(stream)) {
+      return JSON_TOKEN_ERROR;
+    }
+    run = json_scan_plain(stream->buffer + stream->position,
+                          stream->length - stream->position, 0);
+    append_bytes(stream, stream->buffer + stream->position, run);
+    stream->position += run;
+    if (stream->position == stream->length) {
+      continue;
+    }
+    if ((c = read_char(stream)) == '"') {
+      break;
+    } else if (c != '\\') {
+      // control characters have to be escaped
+      return JSON_TOKEN_ERROR;
+    }
+    switch ((c = read_char(stream))) {
+      case '"':
+      case '\\':
+      case '/':
+        append_char(stream, (char)c);
+        break;
+      case 'b':
+        append_char(stream, '\b');
+        break;
+      case 'f':
+        append_char(stream, '\f');
+        break;
+      case 'n':
+        append_char(stream, '\n');
+        break;
+      case 'r':
+        append_char(stream, '\r');
+        break;
+      case 't':
+        append_char(stream, '\t');
+        break;
+      case 'u':
+        if (read_unicode_escape(stream)) {
+          return JSON_TOKEN_ERROR;
+        }
+        break;
+      default:
+        return JSON_TOKEN_ERROR;
+    }
+  }
+  terminate_text(stream);
+  return JSON_TOKEN_STRING;
+}
+
+/**
+ * @brief read a run of decimal digits
+ * @param stream the stream
+ * @return the number of digits read
+ */
+static int read_digits(struct JsonStream *stream) {
+  int c;
+  int count = 0;
+  while ((c = read_char(stream)) >= '0' && c <= '9') {
+    append_char(stream, (char)c);
+    count++;
+  }
+  unread_char(stream, c);
+  return count;
+}
+
+/**
+ * @brief read a number token
+ * @param stream the stream
+ * @param c the first character of the number
+ * @return JSON_TOKEN_NUMBER or JSON_TOKEN_ERROR
+ */
+static enum json_token read_number(struct JsonStream *stream, int c) {
+  if (c == '-') {
+    append_char(stream, (char)c);
+    c = read_char(stream);
+  }
+  if (c == '0') {
+    append_char(stream, (char)c);
+  } else if (c >= '1' && c <= '9') {
+    append_char(stream, (char)c);
+    read_digits(stream);
+  } else {
+    return JSON_TOKEN_ERROR;
+  }
+  if ((c = read_char(stream)) == '.') {
+    append_char(stream, (char)c);
+    if (!read_digits(stream)) {
+      return JSON_TOKEN_ERROR;
+    }
+    c = read_char(stream);
+  }
+  if (c == 'e' || c == 'E') {
+    append_char(stream, (char)c);
+    if ((c = read_char(stream)) == '+' || c == '-') {
+      append_char(stream, (char)c);
+    } else {
+      unread_char(stream, c);
+    }
+    if (!read_digits(stream)) {
+      return JSON_TOKEN_ERROR;
+    }
+    c = read_char(stream);
+  }
+  unread_char(stream, c);
+  if (!ends_scalar(c)) {
+    return JSON_TOKEN_ERROR;
+  }
+  terminate_text(stream);
+  return JSON_TOKEN_NUMBER;
+}
+
+/**
+ * @brief read the rest of a literal like true, false or null
+ * @param stream the stream
+ * @param literal the literal, its first character was already read
+ * @param token the token returned when the literal matches
+ * @return token or JSON_TOKEN_ERROR
+ */
+static enum json_token read_literal(struct JsonStream *stream,
+                                    const char *literal,
+                                    enum json_token token) {
+  int next;
+  for (const char *c = literal + 1; *c; c++) {
+    if (read_char(stream) != *c) {
+      return JSON_TOKEN_ERROR;
+    }
+  }
+  next = read_char(stream);
+  unread_char(stream, next);
+  if (!ends_scalar(next)) {
+    return JSON_TOKEN_ERROR;
+  }
+  for (const char *c = literal; *c; c++) {
+    append_char(stream, *c);
+  }
+  terminate_text(stream);
+  return token;
+}
+
+/**
+ * @brief read the next token of the input
+ * The text of scalar tokens is available through json_stream_text until the
+ * next token is read.
+ * @param stream the stream
+ * @return the token, JSON_TOKEN_END at the end of the input
+ */
+enum json_token json_stream_next(struct JsonStream *stream) {
+  int c;
+  vector_set_size(stream->text, 0);
+  c = read_structural(stream);
+
+  switch (c) {
+    case EOF:
+      return JSON_TOKEN_END;
+    case '{':
+      return JSON_TOKEN_OBJECT_START;
+    case '}':
+      return JSON_TOKEN_OBJECT_END;
+    case '[':
+      return JSON_TOKEN_ARRAY_START;
+    case ']':
+      return JSON_TOKEN_ARRAY_END;
+    case ':':
+      return JSON_TOKEN_COLON;
+    case ',':
+      return JSON_TOKEN_COMMA;
+    case '"':
+      return read_string(stream);
+    case 't':
+      return read_literal(stream, "true", JSON_TOKEN_TRUE);
+    case 'f':
+      return read_literal(stream, "false", JSON_TOKEN_FALSE);
+    case 'n':
+      return read_literal(stream, "null", JSON_TOKEN_NULL);
+    default:
+      return read_number(stream, c);
+  }
+}
+
+/**
+ * @brief get the text of the last token
+ * Strings are unescaped, numbers and literals are returned as written.
+ * @param stream the stream
+ * @return the text or NULL if the token has no text
+ */
+const char *json_stream_text(struct JsonStream *stream) {
+  return vector_size(stream->text) ? stream->text : NULL;
+}
+
+/**
+ * @brief check if a token is a string, number or boolean
+ * @param token the token
+ * @return 1 if scalar else 0
+ */
+int json_token_is_scalar(enum json_token token) {
+  return token == JSON_TOKEN_STRING || token == JSON_TOKEN_NUMBER ||
+         token == JSON_TOKEN_TRUE || token == JSON_TOKEN_FALSE;
+}
+
+/**
+ * @brief free the buffers of a stream
+ * @param stream the stream
+ */
+void json_stream_free(struct JsonStream *stream) {
+  vector_free(stream->text);
+  stream->text = NULL;
+}
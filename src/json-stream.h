@@ -0,0 +1,55 @@
+#ifndef RESTCONF_JSON_STREAM_H
+#define RESTCONF_JSON_STREAM_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "json-scan.h"
+
+/**
+ * The tokens of a JSON text
+ */
+enum json_token {
+  JSON_TOKEN_ERROR,
+  JSON_TOKEN_END,
+  JSON_TOKEN_OBJECT_START,
+  JSON_TOKEN_OBJECT_END,
+  JSON_TOKEN_ARRAY_START,
+  JSON_TOKEN_ARRAY_END,
+  JSON_TOKEN_COLON,
+  JSON_TOKEN_COMMA,
+  JSON_TOKEN_STRING,
+  JSON_TOKEN_NUMBER,
+  JSON_TOKEN_TRUE,
+  JSON_TOKEN_FALSE,
+  JSON_TOKEN_NULL
+};
+
+#define JSON_STREAM_BUFFER_SIZE 4096
+
+/**
+ * A JSON tokenizer that reads its input in chunks while it is tokenized
+ * Each chunk is indexed when it is read, tokens start at the indexed
+ * structural bytes.
+ */
+struct JsonStream {
+  FILE *in;
+  size_t remaining;
+  char buffer[JSON_STREAM_BUFFER_SIZE];
+  size_t position;
+  size_t length;
+  char *text;
+  struct JsonScanState scan;
+  unsigned int structurals[JSON_STREAM_BUFFER_SIZE];
+  size_t structural_count;
+  size_t next_structural;
+};
+
+#define INIT_JSON_STREAM(in, length) \
+  { (in), (length), {0}, 0, 0, NULL, INIT_JSON_SCAN_STATE(), {0}, 0, 0 }
+
+enum json_token json_stream_next(struct JsonStream *stream);
+const char *json_stream_text(struct JsonStream *stream);
+int json_token_is_scalar(enum json_token token);
+void json_stream_free(struct JsonStream *stream);
+
+#endif  // RESTCONF_JSON_STREAM_H
@@ -0,0 +1,191 @@
+#include "json-writer.h"
+#include <inttypes.h>
+#include <string.h>
+#include "json-scan.h"
+
+/**
+ * @brief get the length of a valid UTF-8 sequence
+ * Overlong encodings, surrogates and code points above U+10FFFF are invalid
+ * (RFC 3629).
+ * @param data the bytes starting with a byte above 0x7F
+ * @param length the number of bytes
+ * @return the length of the sequence or 0 if it is invalid
+ */
+static size_t utf8_sequence_length(const unsigned char *data, size_t length) {
+  unsigned char low = 0x80;
+  unsigned char high = 0xBF;
+  size_t count;
+  if (data[0] >= 0xC2 && data[0] <= 0xDF) {
+    count = 2;
+  } else if (data[0] >= 0xE0 && data[0] <= 0xEF) {
+    count = 3;
+    if (data[0] == 0xE0) {
+      low = 0xA0;
+    } else if (data[0] == 0xED) {
+      high = 0x9F;
+    }
+  } else if (data[0] >= 0xF0 && data[0] <= 0xF4) {
+    count = 4;
+    if (data[0] == 0xF0) {
+      low = 0x90;
+    } else if (data[0] == 0xF4) {
+      high = 0x8F;
+    }
+  } else {
+    return 0;
+  }
+  if (length < count || data[1] < low || data[1] > high) {
+    return 0;
+  }
+  for (size_t i = 2; i < count; i++) {
+    if (data[i] < 0x80 || data[i] > 0xBF) {
+      return 0;
+    }
+  }
+  return count;
+}
+
+/**
+ * @brief write a string as quoted JSON string
+ * Runs that need no escaping are written as a whole, invalid UTF-8 is
+ * replaced by U+FFFD.
+ * @param out the output
+ * @param value the string
+ * @param length the length of the string
+ */
+void json_write_string(FILE *out, const char *value, size_t length) {
+  size_t i = 0;
+  fputc('"', out);
+  while (i < length) {
+    size_t run = json_scan_plain(value + i, length - i, 1);
+    unsigned char c;
+    fwrite(value + i, sizeof(char), run, out);
+    if ((i += run) == length) {
+      break;
+    }
+    c = (unsigned char)value[i];
+    if (c > 0x7F) {
+      size_t sequence =
+          utf8_sequence_length((const unsigned char *)value + i, length - i);
+      if (sequence) {
+        fwrite(value + i, sizeof(char), sequence, out);
+        i += sequence;
+      } else {
+        fputs("\\ufffd", out);
+        i++;
+      }
+      continue;
+    }
+    switch (c) {
+      case '"':
+        fputs("\\\"", out);
+        break;
+      case '\\':
+        fputs("\\\\", out);
+        break;
+      case '\b':
+        fputs("\\b", out);
+        break;
+      case '\f':
+        fputs("\\f", out);
+        break;
+      case '\n':
+        fputs("\\n", out);
+        break;
+      case '\r':
+        fputs("\\r", out);
+        break;
+      case '\t':
+        fputs("\\t", out);
+        break;
+      default:
+        fprintf(out, "\\u%04x", c);
+        break;
+    }
+    i++;
+  }
+  fputc('"', out);
+}
+
+/**
+ * @brief write the indentation of a line
+ * @param out the output
+ * @param depth the depth of the value
+ */
+void json_write_indent(FILE *out, int depth) {
+  fputc('\n', out);
+  for (int i = 0; i < depth; i++) {
+    fputs("  ", out);
+  }
+}
+
+/**
+ * @brief write a JSON value
+ * @param out the output
+ * @param jobj the value
+ * @param depth the depth of the value
+ */
+static void write_value(FILE *out, struct json_object *jobj, int depth) {
+  switch (json_object_get_type(jobj)) {
+    case json_type_object: {
+      int first = 1;
+      fputc('{', out);
+      json_object_object_foreach(jobj, key, val) {
+        fputs(first ? "" : ",", out);
+        json_write_indent(out, depth + 1);
+        json_write_string(out, key, strlen(key));
+        fputs(": ", out);
+        write_value(out, val, depth + 1);
+        first = 0;
+      }
+      if (first) {
+        fputs(" }", out);
+      } else {
+        json_write_indent(out, depth);
+        fputc('}', out);
+      }
+      break;
+    }
+    case json_type_array: {
+      int length = json_object_array_length(jobj);
+      fputc('[', out);
+      for (int i = 0; i < length; i++) {
+        fputs(i ? "," : "", out);
+        json_write_indent(out, depth + 1);
+        write_value(out, json_object_array_get_idx(jobj, i), depth + 1);
+      }
+      if (!length) {
+        fputs(" ]", out);
+      } else {
+        json_write_indent(out, depth);
+        fputc(']', out);
+      }
+      break;
+    }
+    case json_type_string:
+      json_write_string(out, json_object_get_string(jobj),
+                        json_object_get_string_len(jobj));
+      break;
+    case json_type_int:
+      fprintf(out, "%" PRId64, json_object_get_int64(jobj));
+      break;
+    case json_type_boolean:
+      fputs(json_object_get_boolean(jobj) ? "true" : "false", out);
+      break;
+    case json_type_double:
+      fputs(json_object_to_json_string(jobj), out);
+      break;
+    default:
+      fputs("null", out);
+      break;
+  }
+}
+
+/**
+ * @brief write a JSON value indented by two spaces per level
+ * @param out the output
+ * @param jobj the value
+ */
+void json_write_pretty(FILE *out, struct json_object *jobj) {
+  write_value(out, jobj, 0);
+}
@@ -0,0 +1,12 @@
+#ifndef RESTCONF_JSON_WRITER_H
+#define RESTCONF_JSON_WRITER_H
+
+#include <json-c/json.h>
+#include <stddef.h>
+#include <stdio.h>
+
+void json_write_string(FILE *out, const char *value, size_t length);
+void json_write_indent(FILE *out, int depth);
+void json_write_pretty(FILE *out, struct json_object *jobj);
+
+#endif  // RESTCONF_JSON_WRITER_H
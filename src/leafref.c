@@ -0,0 +1,171 @@
+#include "leafref.h"
+#include <string.h>
+#include "generated/yang.h"
+#include "hash-set.h"
+#include "uci/backend.h"
+#include "vector.h"
+
+/**
+ * The values of an option in all sections it is stored in
+ */
+struct LeafrefIndex {
+  const struct YangUciOption *option;
+  struct HashSet values;
+};
+
+/**
+ * @brief compare two strings that may be NULL
+ * @return 1 if both are NULL or equal else 0
+ */
+static int optional_equal(const char *a, const char *b) {
+  if (!a || !b) {
+    return a == b;
+  }
+  return strcmp(a, b) == 0;
+}
+
+/**
+ * @brief check if two UCI options are the same
+ * @return 1 if they are else 0
+ */
+static int same_option(const struct YangUciOption *a,
+                       const struct YangUciOption *b) {
+  return optional_equal(a->package, b->package) &&
+         optional_equal(a->section, b->section) &&
+         optional_equal(a->section_name, b->section_name) &&
+         optional_equal(a->option, b->option);
+}
+
+/**
+ * @brief check if a package is in a list of package names
+ * @return 1 if it is else 0
+ */
+static int package_listed(char **package_list, const char *package) {
+  for (size_t i = 0; i < vector_size(package_list); i++) {
+    if (strcmp(package_list[i], package) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief add the values of an option in a section to an index
+ * @param section the section
+ * @param option the option
+ * @param values the index
+ * @return 0 if success else 1
+ */
+static int index_section(const struct UciMapSection *section,
+                         const char *option, struct HashSet *values) {
+  struct UciMapOption *o = uci_map_option(section, option);
+  for (size_t i = 0; o && i < vector_size(o->values); i++) {
+    char *value = uci_slice_dup(o->values[i]);
+    if (!value || hash_set_add(values, value) < 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief build the index of the values of an option
+ * The values are read from the snapshot of the selected datastore, which
+ * holds the staged changes of the request.
+ * @param option the option
+ * @param values the index
+ * @return 0 if success else 1
+ */
+static int index_option(const struct YangUciOption *option,
+                        struct HashSet *values) {
+  struct UciMap loaded = INIT_UCI_MAP();
+  const struct UciMapSection **sections = NULL;
+  int retval = 1;
+
+  if (datastore_backend()->sections(option->package, &loaded)) {
+    return 1;
+  }
+  if (option->section_name) {
+    const struct UciMapSection *section =
+        uci_map_section(&loaded, option->section_name);
+    if (section && index_section(section, option->option, values)) {
+      goto done;
+    }
+  } else {
+    sections = uci_map_sections_of_type(&loaded, option->section);
+    for (size_t i = 0; i < vector_size(sections); i++) {
+      if (index_section(sections[i], option->option, values)) {
+        goto done;
+      }
+    }
+  }
+  retval = 0;
+done:
+  vector_free(sections);
+  uci_map_free(&loaded);
+  return retval;
+}
+
+/**
+ * @brief get the index of a referenced option, it is built on first use
+ * @param indexes the indexes built so far
+ * @param target the referenced option
+ * @return the index or NULL on error
+ */
+static struct HashSet *target_index(struct LeafrefIndex **indexes,
+                                    const struct YangUciOption *target) {
+  struct LeafrefIndex created = {target, INIT_HASH_SET()};
+
+  // leafrefs to the same option share the index
+  for (size_t i = 0; i < vector_size(*indexes); i++) {
+    if (same_option((*indexes)[i].option, target)) {
+      return &(*indexes)[i].values;
+    }
+  }
+  if (index_option(target, &created.values)) {
+    hash_set_free(&created.values);
+    return NULL;
+  }
+  vector_push_back(*indexes, created);
+  return &(*indexes)[vector_size(*indexes) - 1].values;
+}
+
+/**
+ * @brief check that every leafref stored in or referencing a package that
+ * the request changes references an existing value
+ * It has to run once the deletes and writes of the request are staged, so
+ * a value the request writes and a referenced value it deletes are both
+ * seen. Each referenced option is indexed once, so a value is checked with
+ * one lookup instead of a scan of the referenced sections.
+ * @param package_list the names of the packages the request changes
+ * @return LEAFREF_MISSING if a value is not referenced else RE_OK
+ */
+error leafref_verify(char **package_list) {
+  const struct YangLeafref *leafref = yang_leafrefs();
+  struct LeafrefIndex *indexes = NULL;
+  error err = RE_OK;
+
+  for (; leafref->source.package && err == RE_OK; leafref++) {
+    struct HashSet values = INIT_HASH_SET();
+    struct HashSet *targets = NULL;
+    if (!package_listed(package_list, leafref->source.package) &&
+        !package_listed(package_list, leafref->target.package)) {
+      continue;
+    }
+    if (index_option(&leafref->source, &values) ||
+        !(targets = target_index(&indexes, &leafref->target))) {
+      err = INTERNAL;
+    }
+    for (size_t i = 0; err == RE_OK && i < vector_size(values.items); i++) {
+      if (!hash_set_contains(targets, values.items[i])) {
+        err = LEAFREF_MISSING;
+      }
+    }
+    hash_set_free(&values);
+  }
+  for (size_t i = 0; i < vector_size(indexes); i++) {
+    hash_set_free(&indexes[i].values);
+  }
+  vector_free(indexes);
+  return err;
+}
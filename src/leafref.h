@@ -0,0 +1,28 @@
+#ifndef RESTCONF_LEAFREF_H
+#define RESTCONF_LEAFREF_H
+
+#include "error.h"
+
+/**
+ * The UCI option of a leaf, stored in the named section or in all sections
+ * of the type
+ */
+struct YangUciOption {
+  const char *package;
+  const char *section;
+  const char *section_name;
+  const char *option;
+};
+
+/**
+ * A leafref of the schema, the option its values are stored in and the
+ * option they have to exist in
+ */
+struct YangLeafref {
+  struct YangUciOption source;
+  struct YangUciOption target;
+};
+
+error leafref_verify(char **package_list);
+
+#endif  // RESTCONF_LEAFREF_H
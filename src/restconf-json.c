@@ -1,7 +1,9 @@
 #include "restconf-json.h"
 #include <stdio.h>
 #include "error.h"
+#include "json-writer.h"
 #include "restconf.h"
+#include "util.h"
 #include "yang-util.h"
 
 /**
@@ -47,8 +49,8 @@ struct json_object* json_get_object_from_map(struct json_object* jobj,
  * @param jobj the json_object to be printed
  */
 void json_pretty_print(struct json_object* jobj) {
-  printf("%s\n", json_object_to_json_string_ext(
-                     jobj, JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY));
+  json_write_pretty(stdout, jobj);
+  printf("\n");
 }
 
 /**
@@ -121,6 +123,49 @@ static error check_mandatory_values(struct json_object* mandatory,
   return RE_OK;
 }
 
+/**
+ * @brief encode the values of the named leaves of a list item as tuple
+ * @param names the JSON array of leaf names
+ * @param item the JSON list item
+ * @param tuple set to the encoded tuple
+ * @return error in case of error else RE_OK
+ */
+static error item_tuple(struct json_object* names, struct json_object* item,
+                        char** tuple) {
+  size_t count = json_object_array_length(names);
+  const char* values[count ? count : 1];
+  for (size_t i = 0; i < count; i++) {
+    const char* name = NULL;
+    struct json_object* value = NULL;
+    if ((name = json_object_get_string(
+             json_object_array_get_idx(names, i))) == NULL) {
+      return YANG_SCHEMA_ERROR;
+    }
+    json_object_object_get_ex(item, name, &value);
+    if (value == NULL || (values[i] = json_object_get_string(value)) == NULL) {
+      return KEY_NOT_PRESENT;
+    }
+  }
+  if (!(*tuple = tuple_encode(values, count))) {
+    return INTERNAL;
+  }
+  return RE_OK;
+}
+
+/**
+ * @brief add a tuple to an index
+ * @param set the set of tuples already in the list
+ * @param tuple the encoded tuple
+ * @return IDENTICAL_KEYS if the tuple is already in the list else RE_OK
+ */
+static error index_tuple(struct HashSet* set, char* tuple) {
+  int added = hash_set_add(set, tuple);
+  if (added < 0) {
+    return INTERNAL;
+  }
+  return added ? RE_OK : IDENTICAL_KEYS;
+}
+
 /**
  * @brief verify a JSON list against a YANG list node
  * @param list the JSON list
@@ -129,10 +174,25 @@ static error check_mandatory_values(struct json_object* mandatory,
  */
 error json_yang_verify_list(struct json_object* list,
                             struct json_object* yang) {
-  int keys_exist = 1;
-  int mandatory_exist = 1;
-  int unique_exist = 1;
-  int leaf_as_name_exist = 1;
+  struct ListIndex index = INIT_LIST_INDEX();
+  error err = json_yang_verify_list_indexed(list, yang, &index);
+  list_index_free(&index);
+  return err;
+}
+
+/**
+ * @brief verify new JSON list items against a YANG list node and the keys
+ * and unique values already in the list
+ * Every item is checked once against the index and added to it, so the
+ * check is linear in the number of new items.
+ * @param list the JSON list of new items
+ * @param yang the YANG list node
+ * @param index the index of the items already in the list
+ * @return error in case of error else RE_OK
+ */
+error json_yang_verify_list_indexed(struct json_object* list,
+                                    struct json_object* yang,
+                                    struct ListIndex* index) {
   struct json_object* keys = NULL;
   struct json_object* mandatory = NULL;
   struct json_object* unique = NULL;
@@ -141,88 +201,50 @@ error json_yang_verify_list(struct json_object* list,
     return INVALID_TYPE;
   }
 
-  if (!(keys = json_get_array(yang, YANG_KEYS))) {
-    // No keys defined in YANG
-    keys_exist = 0;
-  }
-  if (!(unique = json_get_array(yang, YANG_UNIQUE))) {
-    unique_exist = 0;
-  }
-  if (!(mandatory = json_get_array(yang, YANG_MANDATORY))) {
-    mandatory_exist = 0;
-  }
+  keys = json_get_array(yang, YANG_KEYS);
+  unique = json_get_array(yang, YANG_UNIQUE);
+  mandatory = json_get_array(yang, YANG_MANDATORY);
   for (size_t list_i = 0; list_i < json_object_array_length(list); list_i++) {
-    struct json_object* key_values = NULL;
-    struct json_object* unique_values = NULL;
     struct json_object* list_item = json_object_array_get_idx(list, list_i);
-    if (keys_exist) {
-      if (json_extract_key_values(keys, list_item, &key_values) != RE_OK) {
+    char* tuple = NULL;
+    error err;
+    if (keys) {
+      if (item_tuple(keys, list_item, &tuple) != RE_OK) {
         return KEY_NOT_PRESENT;
       }
+      if ((err = index_tuple(&index->keys, tuple)) != RE_OK) {
+        return err;
+      }
     }
 
-    if (unique_exist) {
-      if (json_extract_key_values(unique, list_item, &unique_values) != RE_OK) {
+    if (unique) {
+      if (item_tuple(unique, list_item, &tuple) != RE_OK) {
         return KEY_NOT_PRESENT;
       }
+      if ((err = index_tuple(&index->unique, tuple)) != RE_OK) {
+        return err;
+      }
     }
 
-    if (mandatory_exist) {
+    if (mandatory) {
       if (check_mandatory_values(mandatory, list_item) != RE_OK) {
         return MANDATORY_NOT_PRESENT;
       }
     }
-
-    for (size_t verify_i = list_i + 1;
-         verify_i < json_object_array_length(list) && keys_exist; verify_i++) {
-      int different = 0;
-      json_object_object_foreach(key_values, key, value) {
-        struct json_object* object_key_value = NULL;
-        const char* key_value = json_object_get_string(value);
-        struct json_object* list_item_verify =
-            json_object_array_get_idx(list, verify_i);
-        json_object_object_get_ex(list_item_verify, key, &object_key_value);
-        if (key_value == NULL) {
-          return KEY_NOT_PRESENT;
-        }
-        const char* object_key_value_string =
-            json_object_get_string(object_key_value);
-        if (strcmp(key_value, object_key_value_string) != 0) {
-          different = 1;
-        }
-      }
-      if (!different) {
-        return IDENTICAL_KEYS;
-      }
-      different = 0;
-      if (!unique_exist) {
-        continue;
-      }
-      json_object_object_foreach(unique_values, uniqueKey, uniqueValue) {
-        struct json_object* object_unique_value = NULL;
-        const char* key_value = json_object_get_string(uniqueValue);
-        struct json_object* list_item_verify =
-            json_object_array_get_idx(list, verify_i);
-        json_object_object_get_ex(list_item_verify, uniqueKey,
-                                  &object_unique_value);
-        if (key_value == NULL) {
-          return KEY_NOT_PRESENT;
-        }
-        const char* object_key_value_string =
-            json_object_get_string(object_unique_value);
-        if (strcmp(key_value, object_key_value_string) != 0) {
-          different = 1;
-        }
-      }
-      if (!different) {
-        return IDENTICAL_KEYS;
-      }
-    }
   }
 
   return RE_OK;
 }
 
+/**
+ * @brief free the sets of a list index
+ * @param index the list index
+ */
+void list_index_free(struct ListIndex* index) {
+  hash_set_free(&index->keys);
+  hash_set_free(&index->unique);
+}
+
 /**
  * @brief check if value in JSON array
  * @param array the JSON array
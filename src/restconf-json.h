@@ -5,6 +5,18 @@
 #include <stdbool.h>
 #include "error.h"
 #include "generated/yang.h"
+#include "hash-set.h"
+
+/**
+ * The encoded key and unique value tuples of the items of a list
+ */
+struct ListIndex {
+  struct HashSet keys;
+  struct HashSet unique;
+};
+
+#define INIT_LIST_INDEX() \
+  { INIT_HASH_SET(), INIT_HASH_SET() }
 
 #define json_array_forloop(array, index) \
   int index;                             \
@@ -17,6 +29,10 @@ struct json_object* json_get_object_from_map(struct json_object* jobj,
 void json_pretty_print(struct json_object* jobj);
 struct json_object* json_yang_type_format(yang_type type, const char* val);
 error json_yang_verify_list(struct json_object* list, struct json_object* yang);
+error json_yang_verify_list_indexed(struct json_object* list,
+                                    struct json_object* yang,
+                                    struct ListIndex* index);
+void list_index_free(struct ListIndex* index);
 int json_value_in_array(struct json_object* array, char* value);
 yang_type json_extract_yang_type(struct json_object* item);
 error json_extract_key_values(struct json_object* keys,
@@ -1,10 +1,15 @@
 #include "restconf-method.h"
 #include "error.h"
+#include "hash-set.h"
 #include "http.h"
+#include "leafref.h"
 #include "restconf-json.h"
+#include "restconf-stream.h"
 #include "restconf-verify.h"
 #include "restconf.h"
+#include "uci/backend.h"
 #include "uci/cmd.h"
+#include "uci/uci-emit.h"
 #include "uci/uci-get.h"
 #include "uci/uci-util.h"
 #include "url.h"
@@ -12,6 +17,7 @@
 #include "vector.h"
 #include "yang-util.h"
 #include "yang-verify.h"
+#include "yang-xpath.h"
 
 static UciWritePair **verify_content_yang(struct json_object *content,
                                           struct json_object *yang_node,
@@ -46,35 +52,27 @@ static UciWritePair **verify_content_yang(struct json_object *content,
       return NULL;
     }
     int list_length = uci_list_length(path);
+    // entries appended to an anonymous list cannot exist yet
+    int anonymous =
+        json_get_string(yang_node, YANG_UCI_LEAF_AS_NAME) == NULL &&
+        json_get_string(yang_node, YANG_UCI_KEY_HASH_NAME) == NULL;
     if (root) {
       if (value_type != json_type_object) {
         *err = MULTIPLE_OBJECTS;
         return NULL;
       }
-      struct json_object *existing_values = NULL;
-      if (check_exists) {
-        existing_values = uci_get_list(yang_node, path, err);
-        if (*err != RE_OK) {
-          return NULL;
-        }
-      }
-      if (!existing_values) {
-        existing_values = json_object_new_array();
-      }
-      // combine with uci values when root is list
-      if (value_type == json_type_array) {
-        json_array_forloop(content, index) {
-          struct json_object *item = json_object_array_get_idx(content, index);
-          if (!item) {
-            *err = INTERNAL;
-            return NULL;
-          }
-          json_object_array_add(existing_values, item);
-        }
-      } else {
-        json_object_array_add(existing_values, content);
+      // only the new entry is checked against the keys already in the list
+      struct ListIndex index = INIT_LIST_INDEX();
+      if (check_exists &&
+          (*err = uci_get_list_index(yang_node, path, &index)) != RE_OK) {
+        list_index_free(&index);
+        return NULL;
       }
-      *err = json_yang_verify_list(existing_values, yang_node);
+      struct json_object *added = json_object_new_array();
+      json_object_array_add(added, json_object_get(content));
+      *err = json_yang_verify_list_indexed(added, yang_node, &index);
+      json_object_put(added);
+      list_index_free(&index);
       if (*err != RE_OK) {
         return NULL;
       }
@@ -96,12 +94,15 @@ static UciWritePair **verify_content_yang(struct json_object *content,
         struct json_object *tmp = json_object_array_get_idx(content, index);
         path->index = pos;
         path->where = 1;
-        UciWritePair **tmp_list =
-            verify_content_yang(tmp, yang_node, path, err, 0, check_exists);
+        UciWritePair **tmp_list = verify_content_yang(
+            tmp, yang_node, path, err, 0,
+            check_exists && !(anonymous && pos >= list_length));
         if (*err != RE_OK) {
           free_uci_write_list(tmp_list);
           return NULL;
         }
+        vector_reserve(command_list,
+                       vector_size(command_list) + vector_size(tmp_list));
         for (size_t i = 0; i < vector_size(tmp_list); i++) {
           vector_push_back(command_list, tmp_list[i]);
         }
@@ -110,12 +111,15 @@ static UciWritePair **verify_content_yang(struct json_object *content,
     } else {
       path->index = (path->where || !root) ? path->index : list_length;
       path->where = 1;
-      UciWritePair **tmp_list =
-          verify_content_yang(content, yang_node, path, err, 0, check_exists);
+      UciWritePair **tmp_list = verify_content_yang(
+          content, yang_node, path, err, 0,
+          check_exists && !(anonymous && path->index >= list_length));
       if (*err != RE_OK) {
         free_uci_write_list(tmp_list);
         return NULL;
       }
+      vector_reserve(command_list,
+                     vector_size(command_list) + vector_size(tmp_list));
       for (size_t i = 0; i < vector_size(tmp_list); i++) {
         vector_push_back(command_list, tmp_list[i]);
       }
@@ -127,6 +131,10 @@ static UciWritePair **verify_content_yang(struct json_object *content,
   }
   if (yang_is_list(child_type)) {
       get_leaf_as_name(yang_node, content, path);
+      if (get_key_hash_name(yang_node, content, path)) {
+        *err = INTERNAL;
+        return NULL;
+      }
   }
   json_object_object_foreach(content, key, val) {
     struct json_object *child = NULL;
@@ -135,11 +143,7 @@ static UciWritePair **verify_content_yang(struct json_object *content,
     if (split_pair_by_char(key, &module, &split_key, ':')) {
       split_key = key;
     }
-    if (module) {
-      free(module);
-    }
     child = json_get_object_from_map(yang_node, split_key);
-    free(split_key);
     if (!child) {
       *err = NO_SUCH_ELEMENT;
       return NULL;
@@ -151,6 +155,8 @@ static UciWritePair **verify_content_yang(struct json_object *content,
       free_uci_write_list(tmp_list);
       return NULL;
     }
+    vector_reserve(command_list,
+                   vector_size(command_list) + vector_size(tmp_list));
     for (size_t i = 0; i < vector_size(tmp_list); i++) {
       vector_push_back(command_list, tmp_list[i]);
     }
@@ -160,20 +166,61 @@ static UciWritePair **verify_content_yang(struct json_object *content,
   return command_list;
 }
 
-static error get_list_item_where(struct json_object *yang, char *keylist,
+/**
+ * @brief select the entry of a list whose section name follows from its keys
+ * The entry is looked up by its name instead of reading the key options of
+ * the entries before it. The section name takes precedence over the index
+ * in the path.
+ * @param name the section name of the entry
+ * @param uci the UCI path of the list
+ * @return LIST_UNDEFINED_KEY if the entry does not exist else RE_OK
+ */
+static error get_named_list_item(char *name, struct UciPath *uci) {
+  if (!(uci->section = name)) {
+    return INTERNAL;
+  }
+  uci->where = 1;
+  uci->index = 0;
+  if (!uci_named_section_exists(uci)) {
+    uci->index = uci_list_length(uci);
+    return LIST_UNDEFINED_KEY;
+  }
+  return RE_OK;
+}
+
+static error get_list_item_where(struct json_object *yang,
+                                 struct PathSegment *segment,
                                  struct UciPath *uci) {
   struct json_object *keys = NULL;
+  char *key_string = segment->keys;
+  const char *leaf_as_name = NULL;
   int array_length;
+  error err = RE_OK;
 
   if (!(keys = json_get_array(yang, YANG_KEYS))) {
     return YANG_SCHEMA_ERROR;
   }
   array_length = json_object_array_length(keys);
-  rvec keylist_vec = clist_to_vec(keylist);
-  if (!keylist_vec || array_length != vector_size(keylist_vec)) {
+  if (array_length != segment->key_count) {
     // not as many keys as keys specified
     return LIST_UNDEFINED_KEY;
   }
+  if (array_length == 1 &&
+      (leaf_as_name = json_get_string(yang, YANG_UCI_LEAF_AS_NAME)) &&
+      strcmp(json_object_get_string(json_object_array_get_idx(keys, 0)),
+             leaf_as_name) == 0) {
+    return get_named_list_item(str_dup(segment->keys), uci);
+  }
+  if (json_get_string(yang, YANG_UCI_KEY_HASH_NAME)) {
+    const char *values[array_length];
+    for (int index = 0; index < array_length; index++) {
+      values[index] = key_string;
+      if (index + 1 < array_length) {
+        key_string = path_key_next(key_string);
+      }
+    }
+    return get_named_list_item(uci_key_hash_name(yang, values), uci);
+  }
   map_str2str key_value[array_length];
   for (int index = 0; index < array_length; index++) {
     struct json_object *key = NULL;
@@ -183,19 +230,25 @@ static error get_list_item_where(struct json_object *yang, char *keylist,
 
     key = json_object_array_get_idx(keys, index);
     if (!key || json_object_get_type(key) != json_type_string) {
-      return YANG_SCHEMA_ERROR;
+      err = YANG_SCHEMA_ERROR;
+      goto done;
     }
     yang_option_name = json_object_get_string(key);
     key_child = json_get_object_from_map(yang, yang_option_name);
     if (!key_child) {
-      return LEAF_NO_OPTION;
+      err = LEAF_NO_OPTION;
+      goto done;
     }
     uci_option_name = json_get_string(key_child, YANG_UCI_OPTION);
     if (uci_option_name == NULL) {
-      return LEAF_NO_OPTION;
+      err = LEAF_NO_OPTION;
+      goto done;
     }
     key_value[index].key = (char *)uci_option_name;
-    key_value[index].str = keylist_vec[index];
+    key_value[index].str = key_string;
+    if (index + 1 < array_length) {
+      key_string = path_key_next(key_string);
+    }
   }
   struct UciWhere where = {
       .path = uci, .key_value = key_value, .key_value_length = array_length};
@@ -203,18 +256,20 @@ static error get_list_item_where(struct json_object *yang, char *keylist,
   if (where_index == -1) {
     uci->index = uci_list_length(uci);
     uci->where = 1;
-    return LIST_UNDEFINED_KEY;
+    err = LIST_UNDEFINED_KEY;
+    goto done;
   }
 
   uci->where = 1;
   uci->index = where_index;
-  vector_free(keylist_vec);
-  return RE_OK;
+done:
+  return err;
 }
 
-static error check_path(struct json_object **root_yang, char **path,
-                        size_t start, size_t end, struct UciPath *uci,
-                        int check_keys, int stop_at_key) {
+static error check_path(struct json_object **root_yang,
+                        struct PathSegment *path, size_t start, size_t end,
+                        struct UciPath *uci, int check_keys,
+                        int stop_at_key) {
   struct json_object *iter = *root_yang;
   struct json_object *keys = NULL;
   size_t i;
@@ -222,44 +277,29 @@ static error check_path(struct json_object **root_yang, char **path,
     return INTERNAL;
   }
   for (i = start; i < end; i++) {
-    char *path_computed = NULL;
-    char *obj = NULL;
-    char *keylist = NULL;
-    char *keylist_encoded = NULL;
     const char *type = NULL;
     struct json_object *child = NULL;
     error err;
 
-    split_pair_by_char(path[i], &obj, &keylist_encoded, '=');
-    if (obj && keylist_encoded) {
-      keylist = malloc(strlen(keylist_encoded) + 1);
-      urldecode(keylist, keylist_encoded);
-      free(keylist_encoded);
-    }
-
-    if (!(path_computed = obj)) {
-      path_computed = path[i];
-    }
-
-    if (check_keys && keys && json_value_in_array(keys, path_computed)) {
+    if (check_keys && keys && json_value_in_array(keys, path[i].name)) {
       return DELETING_KEY;
     }
     keys = NULL;
 
-    if (!(child = json_get_object_from_map(iter, path_computed))) {
+    if (!(child = json_get_object_from_map(iter, path[i].name))) {
       return NO_SUCH_ELEMENT;
     }
     get_path_from_yang(child, uci);
     type = json_get_string(child, YANG_TYPE);
     if (type && yang_is_list(type)) {
       int next_is_end = i + 1 == end;
-      if (!keylist && !next_is_end) {
+      if (!path[i].keys && !next_is_end) {
         return LIST_NO_FILTER;
-      } else if (!keylist) {
+      } else if (!path[i].keys) {
         return LIST_NO_FILTER;
       }
 
-      if ((err = get_list_item_where(child, keylist, uci)) != RE_OK) {
+      if ((err = get_list_item_where(child, &path[i], uci)) != RE_OK) {
         if ((err != LIST_UNDEFINED_KEY && !stop_at_key) || !stop_at_key) {
           return err;
         }
@@ -275,12 +315,6 @@ static error check_path(struct json_object **root_yang, char **path,
       }
     }
 
-    if (keylist) {
-      free(keylist);
-    }
-    if (obj) {
-      free(obj);
-    }
     iter = child;
   }
   *root_yang = iter;
@@ -341,17 +375,89 @@ struct json_object *build_recursive(struct json_object *jobj,
   return top_level;
 }
 
-int data_get(struct CgiContext *cgi, char **pathvec) {
+/**
+ * @brief get the generated emitter of the node a path points at
+ * Only paths where no node but the last one is selected by keys are written
+ * by emitters.
+ * @param module_name the name of the module
+ * @param segments the path segments with the top-level node as second one
+ * @return the emitter or NULL if the generic walk has to be used
+ */
+static yang_emitter path_emitter(const char *module_name,
+                                 struct PathSegment *segments) {
+  char path[512] = "";
+  size_t length = 0;
+  for (size_t i = 1; i < vector_size(segments); i++) {
+    int written;
+    if (segments[i].keys && i + 1 < vector_size(segments)) {
+      return NULL;
+    }
+    written = snprintf(path + length, sizeof(path) - length, "%s%s",
+                       i > 1 ? "/" : "", segments[i].name);
+    if (written < 0 || (size_t)written >= sizeof(path) - length) {
+      return NULL;
+    }
+    length += written;
+  }
+  return yang_emitter_for(module_name, path);
+}
+
+/**
+ * @brief write the node of a GET request with its generated emitter
+ * The package is loaded once and written while it is read, no JSON tree is
+ * built.
+ * @param emitter the emitter of the node
+ * @param uci the UCI path of the node
+ * @param module_name the name of the module
+ * @param name the name of the node in the response
+ * @return 0 if response was printed
+ */
+static int data_get_emit(yang_emitter emitter, struct UciPath *uci,
+                         const char *module_name, const char *name) {
+  struct UciEmit emit;
+  const struct UciMapSection *section = NULL;
+  char key[512];
+
+  if (uci_emit_init(&emit, stdout, uci->package)) {
+    return print_error(INTERNAL);
+  }
+  if (strlen(uci->section) != 0 &&
+      !(section = uci_emit_section(&emit, uci->section))) {
+    uci_emit_free(&emit);
+    return print_error(NO_SUCH_ELEMENT);
+  }
+  if (uci->where && section) {
+    // a list entry selected by its section name
+    emit.selected = section;
+    section = NULL;
+  } else {
+    emit.entry = uci->where ? uci->index : -1;
+  }
+  snprintf(key, sizeof(key), "\"%s:%s\": ", module_name, name);
+  content_type_json();
+  headers_end();
+  uci_emit_open(&emit, NULL, '{');
+  emitter(&emit, key, section, UCI_EMIT_KEEP_EMPTY);
+  uci_emit_close(&emit, UCI_EMIT_KEEP_EMPTY);
+  printf("\n");
+  uci_emit_free(&emit);
+  return 0;
+}
+
+int data_get(struct CgiContext *cgi, struct PathSegment *segments) {
   json_object *module = NULL;
   json_object *top_level = NULL;
   json_object *yang_tree = NULL;
   char *module_name = NULL;
   char *top_level_name = NULL;
   const char *type_string = NULL;
+  yang_emitter emitter = NULL;
   int retval = 1;
   error err;
 
-  if (split_pair_by_char(pathvec[1], &module_name, &top_level_name, ':')) {
+  module_name = segments[1].module;
+  top_level_name = segments[1].name;
+  if (!module_name || segments[1].keys) {
     retval = restconf_badrequest();
     goto done;
   }
@@ -370,7 +476,8 @@ int data_get(struct CgiContext *cgi, char **pathvec) {
     goto done;
   }
   get_path_from_yang(top_level, &uci);
-  err = check_path(&top_level, pathvec, 2, vector_size(pathvec), &uci, 0, 0);
+  err =
+      check_path(&top_level, segments, 2, vector_size(segments), &uci, 0, 0);
   if (!top_level || err != RE_OK) {
     retval = print_error(err);
     goto done;
@@ -380,6 +487,13 @@ int data_get(struct CgiContext *cgi, char **pathvec) {
     retval = restconf_badrequest();
     goto done;
   }
+  if ((emitter = path_emitter(module_name, segments))) {
+    retval = data_get_emit(
+        emitter, &uci, module_name,
+        yang_is_list(type_string) ? segments[vector_size(segments) - 1].name
+                                  : top_level_name);
+    goto done;
+  }
   err = RE_OK;
   yang_tree = build_recursive(top_level, &uci, &err, 1);
   if (!yang_tree && err != RE_OK) {
@@ -394,11 +508,8 @@ int data_get(struct CgiContext *cgi, char **pathvec) {
       yang_is_list(type_string)) {
     struct json_object *parent = json_object_new_object();
     char buf[512];
-    char *object_requested = pathvec[vector_size(pathvec) - 1];
-    char *equal_delimiter = strchr(object_requested, '=');
-    int equal_delimiter_index = (size_t)(equal_delimiter - object_requested);
-    retval = snprintf(buf, sizeof(buf), "%s:%.*s", module_name,
-                      equal_delimiter_index, object_requested);
+    retval = snprintf(buf, sizeof(buf), "%s:%s", module_name,
+                      segments[vector_size(segments) - 1].name);
     if (retval < 0) {
       retval = internal_server_error(cgi);
       goto done;
@@ -408,31 +519,26 @@ int data_get(struct CgiContext *cgi, char **pathvec) {
     json_object_put(parent);
   } else if (yang_is_container(type_string)) {
     struct json_object *parent = json_object_new_object();
-    json_object_object_add(parent, pathvec[1], yang_tree);
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s:%s", module_name, top_level_name);
+    json_object_object_add(parent, buf, yang_tree);
     json_pretty_print(parent);
     json_object_put(parent);
   }
   retval = 0;
 done:
-  if (module_name) {
-    free(module_name);
-  }
-  if (top_level_name) {
-    free(top_level_name);
-  }
   if (yang_tree) {
     json_object_put(yang_tree);
   }
   return retval;
 }
 
-int data_post(struct CgiContext *cgi, char **pathvec, int root) {
+int data_post(struct CgiContext *cgi, struct PathSegment *segments, int root) {
   json_object *module = NULL;
   json_object *top_level = NULL;
   struct json_object *content = NULL;
   char *module_name = NULL;
   char *top_level_name = NULL;
-  char *content_raw = NULL;
   char *root_key_copy = NULL;
   char *root_key = NULL;
   struct json_object *root_object = NULL;
@@ -442,17 +548,18 @@ int data_post(struct CgiContext *cgi, char **pathvec, int root) {
   error err;
   enum json_tokener_error parse_error;
   char path_string[512];
-  char key_out[1024];
+  char key_out[1024] = "";
   UciWritePair **cmds = NULL;
+  struct HashSet packages = INIT_HASH_SET();
   struct UciPath uci = INIT_UCI_PATH();
 
-  if ((content_raw = get_content()) == NULL) {
+  if (!(content = get_content_json(&parse_error))) {
     retval = restconf_malformed();
     goto done;
   }
-  content = json_tokener_parse_verbose(content_raw, &parse_error);
-  if (parse_error != json_tokener_success) {
-    retval = restconf_malformed();
+  // the store is checked and changed by one write request at a time
+  if (datastore_backend()->lock()) {
+    retval = print_error(INTERNAL);
     goto done;
   }
   if (json_object_object_length(content) != 1) {
@@ -472,7 +579,9 @@ int data_post(struct CgiContext *cgi, char **pathvec, int root) {
       goto done;
     }
   } else {
-    if (split_pair_by_char(pathvec[1], &module_name, &top_level_name, ':')) {
+    module_name = segments[1].module;
+    top_level_name = segments[1].name;
+    if (!module_name || segments[1].keys) {
       retval = restconf_badrequest();
       goto done;
     }
@@ -495,7 +604,8 @@ int data_post(struct CgiContext *cgi, char **pathvec, int root) {
     content = root_object;
     get_path_from_yang(content, &uci);
   } else {
-    err = check_path(&top_level, pathvec, 2, vector_size(pathvec), &uci, 1, 0);
+    err = check_path(&top_level, segments, 2, vector_size(segments), &uci, 1,
+                     0);
     if (!top_level || err != RE_OK) {
       retval = print_error(err);
       goto done;
@@ -550,8 +660,25 @@ int data_post(struct CgiContext *cgi, char **pathvec, int root) {
     retval = print_error(err);
     goto done;
   }
+  if ((err = yang_constraints_verify(cmds)) != RE_OK) {
+    retval = print_error(err);
+    goto done;
+  }
   vector_push_back(cmds, container_create);
-  write_uci_write_list(cmds);
+  if (write_uci_write_list(cmds, &packages)) {
+    retval = restconf_partial_operation();
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+  if ((err = leafref_verify(packages.items)) != RE_OK) {
+    retval = print_error(err);
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+  if (datastore_backend()->commit(packages.items)) {
+    retval = restconf_partial_operation();
+    goto done;
+  }
   printf("Status: 201 Created\r\n");
   char *protocol = NULL;
   char *slash = "";
@@ -571,27 +698,231 @@ int data_post(struct CgiContext *cgi, char **pathvec, int root) {
          slash, root_key_copy, equal, key_out);
   headers_end();
 done:
-  if (module_name) {
-    free(module_name);
+  if (cmds) {
+    free_uci_write_list(cmds);
+  }
+  hash_set_free(&packages);
+  return retval;
+}
+
+/**
+ * @brief replace the configuration below a node with the verified writes
+ * @param top_level the YANG node whose configuration is replaced
+ * @param delete_uci the UCI path of the node
+ * @param cmds the writes of the new configuration
+ * @return 0 if response was printed
+ */
+static int replace_content(struct json_object *top_level,
+                           struct UciPath *delete_uci, UciWritePair **cmds) {
+  struct HashSet packages = INIT_HASH_SET();
+  struct UciPath *delete = NULL;
+  error err;
+  int retval = 1;
+
+  delete = extract_paths(top_level, delete_uci, &err);
+  if (err != RE_OK) {
+    retval = print_error(err);
+    goto done;
+  }
+
+  for (size_t i = 0; i < vector_size(delete); i++) {
+    if (hash_set_add(&packages, delete[i].package) < 0) {
+      retval = print_error(INTERNAL);
+      goto done;
+    }
+  }
+
+  int created_or_updated = delete_uci_path_list(delete);
+  if (created_or_updated == 1) {
+    retval = print_error(INTERNAL);
+    goto done;
+  }
+
+  // the replaced configuration is no longer part of the saved snapshot
+  if ((err = yang_constraints_verify(cmds)) != RE_OK) {
+    retval = print_error(err);
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+
+  // the saved deletes are committed together with the writes
+  if (write_uci_write_list(cmds, &packages)) {
+    retval = restconf_partial_operation();
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+
+  // the replaced configuration may have held referenced values
+  if ((err = leafref_verify(packages.items)) != RE_OK) {
+    retval = print_error(err);
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+
+  if (datastore_backend()->commit(packages.items)) {
+    retval = restconf_partial_operation();
+    goto done;
+  }
+
+  if (created_or_updated == -1) {
+    printf("Status: 201 Created\r\n");
+    headers_end();
+  } else {
+    printf("Status: 204 No Content\r\n");
+    headers_end();
+  }
+  retval = 0;
+done:
+  if (delete) {
+    vector_free(delete);
   }
-  if (top_level_name) {
-    free(top_level_name);
+  hash_set_free(&packages);
+  return retval;
+}
+
+/**
+ * @brief check if a path addresses a whole top-level container
+ * @param segments the path segments
+ * @return 1 if it does else 0
+ */
+static int is_top_level_container(struct PathSegment *segments) {
+  struct json_object *module = NULL;
+  struct json_object *top_level = NULL;
+  const char *type = NULL;
+  if (vector_size(segments) != 2 || !segments[1].module || segments[1].keys ||
+      !(module = yang_module_exists(segments[1].module)) ||
+      !(top_level = json_get_object_from_map(module, segments[1].name)) ||
+      !(type = json_get_string(top_level, YANG_TYPE))) {
+    return 0;
   }
+  return yang_is_container(type);
+}
+
+/**
+ * @brief replace a top-level container with a body that is verified while it
+ * is parsed
+ * The body is never held in memory as a whole, see content_stream_verify.
+ * @param cgi the cgi context
+ * @param segments the path segments with the top-level container as second one
+ * @return 0 if response was printed
+ */
+static int data_put_stream(struct CgiContext *cgi,
+                           struct PathSegment *segments) {
+  struct ContentStream stream = INIT_CONTENT_STREAM(stdin, 0);
+  struct json_object *module = NULL;
+  struct json_object *top_level = NULL;
+  struct UciPath uci = INIT_UCI_PATH();
+  struct UciPath delete_uci = INIT_UCI_PATH();
+  UciWritePair **cmds = NULL;
+  char *module_name = NULL;
+  char *top_level_name = NULL;
+  char *root_key = NULL;
+  const char *root_name = NULL;
+  error err;
+  int retval = 1;
+
+  if (get_content_length(&stream.json.remaining)) {
+    retval = restconf_malformed();
+    goto done;
+  }
+  if (datastore_backend()->lock()) {
+    retval = print_error(INTERNAL);
+    goto done;
+  }
+  module_name = segments[1].module;
+  top_level_name = segments[1].name;
+  if (!module_name || segments[1].keys) {
+    retval = restconf_badrequest();
+    goto done;
+  }
+  if (!(module = yang_module_exists(module_name))) {
+    retval = restconf_unknown_namespace();
+    goto done;
+  }
+  get_path_from_yang(module, &uci);
+  if (!(top_level = json_get_object_from_map(module, top_level_name))) {
+    retval = restconf_badrequest();
+    goto done;
+  }
+  get_path_from_yang(top_level, &uci);
+  delete_uci = uci;
+
+  if ((err = content_stream_begin(&stream, &root_key)) != RE_OK) {
+    retval = print_error(err);
+    goto done;
+  }
+  // a qualified member has to be of the module of the path
+  if ((root_name = strchr(root_key, ':'))) {
+    if ((size_t)(root_name - root_key) != strlen(module_name) ||
+        strncmp(root_key, module_name, strlen(module_name)) != 0) {
+      retval = restconf_unknown_namespace();
+      goto done;
+    }
+    root_name++;
+  } else {
+    root_name = root_key;
+  }
+  if (strcmp(root_name, top_level_name) != 0) {
+    retval = restconf_badrequest();
+    goto done;
+  }
+  cmds = content_stream_verify(&stream, top_level, &uci, &err);
+  if (err != RE_OK || (err = content_stream_end(&stream)) != RE_OK) {
+    retval = print_error(err);
+    goto done;
+  }
+  retval = replace_content(top_level, &delete_uci, cmds);
+done:
   if (cmds) {
     free_uci_write_list(cmds);
   }
-  if (root_key_copy) {
-    free(root_key_copy);
-  }
+  // the writes point at the section names of the stream
+  content_stream_free(&stream);
   return retval;
 }
 
-int data_put(struct CgiContext *cgi, char **pathvec, int root) {
+/**
+ * @brief check if the key values of a list item are the ones of the path
+ * @param yang the YANG list node
+ * @param item the list item
+ * @param segment the path segment of the list item
+ * @return 1 if the key values match else 0
+ */
+static int list_item_keys_match(struct json_object *yang,
+                                struct json_object *item,
+                                struct PathSegment *segment) {
+  struct json_object *keys = NULL;
+  char *key_string = segment->keys;
+  int length;
+
+  if (!(keys = json_get_array(yang, YANG_KEYS))) {
+    return 0;
+  }
+  length = json_object_array_length(keys);
+  if (length != segment->key_count) {
+    return 0;
+  }
+  for (int i = 0; i < length; i++) {
+    struct json_object *value = NULL;
+    const char *key =
+        json_object_get_string(json_object_array_get_idx(keys, i));
+    if (!key || !json_object_object_get_ex(item, key, &value) ||
+        strcmp(json_object_get_string(value), key_string) != 0) {
+      return 0;
+    }
+    if (i + 1 < length) {
+      key_string = path_key_next(key_string);
+    }
+  }
+  return 1;
+}
+
+int data_put(struct CgiContext *cgi, struct PathSegment *segments, int root) {
   // Cannot update the key values for list item
-  char *content_raw = NULL;
   char *module_name = NULL;
   char *top_level_name = NULL;
   char *root_key = NULL;
+  const char *root_name = NULL;
   struct json_object *root_object = NULL;
   struct json_object *content = NULL;
   struct json_object *module = NULL;
@@ -600,19 +931,20 @@ int data_put(struct CgiContext *cgi, char **pathvec, int root) {
   struct UciPath delete_uci = INIT_UCI_PATH();
   enum json_tokener_error parse_error;
   UciWritePair **cmds = NULL;
-  char **package_list = NULL;
-  struct UciPath *delete = NULL;
-  char key_out[1024];
   error err;
   int retval = 1;
 
-  if ((content_raw = get_content()) == NULL) {
+  if (!root && is_top_level_container(segments)) {
+    // a whole top-level container is replaced, e.g. by a bulk import
+    return data_put_stream(cgi, segments);
+  }
+
+  if (!(content = get_content_json(&parse_error))) {
     retval = restconf_malformed();
     goto done;
   }
-  content = json_tokener_parse_verbose(content_raw, &parse_error);
-  if (parse_error != json_tokener_success) {
-    retval = restconf_malformed();
+  if (datastore_backend()->lock()) {
+    retval = print_error(INTERNAL);
     goto done;
   }
   if (json_object_object_length(content) != 1) {
@@ -632,7 +964,9 @@ int data_put(struct CgiContext *cgi, char **pathvec, int root) {
       goto done;
     }
   } else {
-    if (split_pair_by_char(pathvec[1], &module_name, &top_level_name, ':')) {
+    module_name = segments[1].module;
+    top_level_name = segments[1].name;
+    if (!module_name || segments[1].keys) {
       retval = restconf_badrequest();
       goto done;
     }
@@ -651,11 +985,12 @@ int data_put(struct CgiContext *cgi, char **pathvec, int root) {
   }
   get_path_from_yang(top_level, &uci);
 
-  if ((vector_size(pathvec) == 2 || root)) {
+  if (root) {
     content = root_object;
     get_path_from_yang(content, &uci);
   } else {
-    err = check_path(&top_level, pathvec, 2, vector_size(pathvec), &uci, 1, 1);
+    err = check_path(&top_level, segments, 2, vector_size(segments), &uci, 1,
+                     1);
     if (!top_level || err != RE_OK) {
       retval = print_error(err);
       goto done;
@@ -667,128 +1002,46 @@ int data_put(struct CgiContext *cgi, char **pathvec, int root) {
     goto done;
   }
 
-  free(module_name);
-  free(top_level_name);
-  module_name = NULL;
-  top_level_name = NULL;
-  split_pair_by_char(root_key, &module_name, &top_level_name, ':');
-  if (!top_level_name) {
-    top_level_name = root_key;
-  }
-  char *item = NULL;
-  char *keys = NULL;
-  char sep = '=';
-  if (vector_size(pathvec) == 2 || root) {
-    sep = ':';
-  }
-  split_pair_by_char(pathvec[vector_size(pathvec) - 1], &item, &keys, sep);
-  if (!item) {
-    item = pathvec[vector_size(pathvec) - 1];
-  }
-  if ((vector_size(pathvec) == 2 || root) &&
-      strcmp(top_level_name, keys) != 0) {
+  // the node in the body has to be the one of the path
+  root_name = strchr(root_key, ':') ? strchr(root_key, ':') + 1 : root_key;
+  if (!root &&
+      strcmp(root_name, segments[vector_size(segments) - 1].name) != 0) {
     retval = restconf_badrequest();
     goto done;
-  } else if (!(vector_size(pathvec) == 2 || root) &&
-             strcmp(top_level_name, item) != 0) {
-    retval = restconf_badrequest();
-    goto done;
-  }
-
-  if (item) free(item);
-  if (keys) free(keys);
-
-  delete_uci = uci;
-
-  if (yang_is_list(json_get_string(top_level, YANG_TYPE))) {
-    struct json_object *keys = NULL;
-    if ((keys = json_get_array(top_level, YANG_KEYS))) {
-      struct json_object *values = NULL;
-      if (json_extract_key_values(keys, root_object, &values) == RE_OK) {
-        json_object_object_foreach(values, key, value) {
-          strcat(key_out, json_object_get_string(value));
-          strcat(key_out, ",");
-        }
-        key_out[strlen(key_out) - 1] = '\0';
-      }
-    }
-  }
-
-  cmds = verify_content_yang(root_object, top_level, &uci, &err,
-                             !(vector_size(pathvec) == 2 || root), 0);
-  if (err != RE_OK) {
-    retval = print_error(err);
-    goto done;
   }
 
-  if (strlen(key_out) > 0) {
-    char *obj = NULL;
-    char *keylist_encoded = NULL;
-    char *keylist = NULL;
-    split_pair_by_char(pathvec[vector_size(pathvec) - 1], &obj,
-                       &keylist_encoded, '=');
-    if (obj && keylist_encoded) {
-      keylist = malloc(strlen(keylist_encoded) + 1);
-      urldecode(keylist, keylist_encoded);
-      free(keylist_encoded);
-    }
-    if (strcmp(keylist, key_out) != 0) {
-      free(obj);
-      free(keylist);
+  // a list entry is given as an array of the one entry (RFC 8040)
+  if (!root && json_object_get_type(root_object) == json_type_array) {
+    const char *type = json_get_string(top_level, YANG_TYPE);
+    if (type && yang_is_list(type) &&
+        json_object_array_length(root_object) == 1) {
+      root_object = json_object_array_get_idx(root_object, 0);
+    } else if (!type || yang_is_list(type) || yang_is_container(type)) {
       retval = restconf_malformed();
       goto done;
     }
-    free(obj);
-    free(keylist);
   }
 
-  delete = extract_paths(top_level, &delete_uci, &err);
+  delete_uci = uci;
+
+  // the target is replaced as a whole, a list is given with all its entries
+  cmds = verify_content_yang(root_object, top_level, &uci, &err, 0, 0);
   if (err != RE_OK) {
     retval = print_error(err);
     goto done;
   }
 
-  int created_or_updated = -1;
-
-  for (size_t i = 0; i < vector_size(delete); i++) {
-    char path_string[512];
-    struct UciPath tmp = delete[i];
-
-    uci_combine_to_path(&tmp, path_string, sizeof(path_string));
-
-    if (!is_in_vector(package_list, tmp.package)) {
-      vector_push_back(package_list, tmp.package);
-    }
-
-    if ((created_or_updated = uci_delete_path(path_string, false)) == 1) {
-      retval = print_error(INTERNAL);
-      uci_revert_all(package_list);
-      goto done;
-    }
-  }
-
-  if (uci_commit_all(package_list)) {
-    retval = restconf_partial_operation();
+  // the key values cannot be changed
+  if (!root && yang_is_list(json_get_string(top_level, YANG_TYPE)) &&
+      segments[vector_size(segments) - 1].keys &&
+      !list_item_keys_match(top_level, root_object,
+                            &segments[vector_size(segments) - 1])) {
+    retval = restconf_malformed();
     goto done;
   }
 
-  write_uci_write_list(cmds);
-
-  if (created_or_updated == -1) {
-    printf("Status: 201 Created\r\n");
-    headers_end();
-  } else {
-    printf("Status: 204 No Content\r\n");
-    headers_end();
-  }
-  retval = 0;
+  retval = replace_content(top_level, &delete_uci, cmds);
 done:
-  if (module_name) {
-    free(module_name);
-  }
-  if (top_level_name) {
-    free(top_level_name);
-  }
   if (cmds) {
     free_uci_write_list(cmds);
   }
@@ -819,32 +1072,31 @@ struct UciPath *extract_paths(struct json_object *node, struct UciPath *uci,
     *err = RE_OK;
     return path_list;
   } else if (yang_is_list(type)) {
-    int list_length = uci_list_length(uci);
     json_object_object_get_ex(node, YANG_MAP, &map);
-    int start = (uci->where) ? uci->index : 0;
-    int end = (uci->where) ? uci->index + 1 : list_length;
-    for (int index = start; index < end; index++) {
-      uci->where = 1;
-      uci->index = start;
-      vector_push_back(path_list, *uci);
-      json_object_object_foreach(map, key, val) {
-        const char *subnode_type = NULL;
-        if (!(subnode_type = json_get_string(val, YANG_TYPE))) {
-          *err = YANG_SCHEMA_ERROR;
+    if (!uci->where) {
+      // the whole list is removed by section type in one pass
+      uci->section = "";
+    }
+    vector_push_back(path_list, *uci);
+    json_object_object_foreach(map, key, val) {
+      const char *subnode_type = NULL;
+      if (!(subnode_type = json_get_string(val, YANG_TYPE))) {
+        *err = YANG_SCHEMA_ERROR;
+        return NULL;
+      }
+      if (yang_is_container(subnode_type) || yang_is_list(subnode_type)) {
+        struct UciPath *nested_path_list = NULL;
+        get_path_from_yang(val, uci);
+        nested_path_list = extract_paths(val, uci, err);
+        if (*err != RE_OK) {
           return NULL;
         }
-        if (yang_is_container(subnode_type) || yang_is_list(subnode_type)) {
-          struct UciPath *nested_path_list = NULL;
-          get_path_from_yang(val, uci);
-          nested_path_list = extract_paths(val, uci, err);
-          if (*err != RE_OK) {
-            return NULL;
-          }
-          for (size_t i = 0; i < vector_size(nested_path_list); i++) {
-            vector_push_back(path_list, nested_path_list[i]);
-          }
-          vector_free(nested_path_list);
+        vector_reserve(path_list,
+                       vector_size(path_list) + vector_size(nested_path_list));
+        for (size_t i = 0; i < vector_size(nested_path_list); i++) {
+          vector_push_back(path_list, nested_path_list[i]);
         }
+        vector_free(nested_path_list);
       }
     }
     uci->option = "";
@@ -868,6 +1120,8 @@ struct UciPath *extract_paths(struct json_object *node, struct UciPath *uci,
       if (*err != RE_OK) {
         return NULL;
       }
+      vector_reserve(path_list,
+                     vector_size(path_list) + vector_size(nested_path_list));
       for (size_t i = 0; i < vector_size(nested_path_list); i++) {
         vector_push_back(path_list, nested_path_list[i]);
       }
@@ -878,7 +1132,8 @@ struct UciPath *extract_paths(struct json_object *node, struct UciPath *uci,
   return path_list;
 }
 
-int data_delete(struct CgiContext *cgi, char **pathvec, int root) {
+int data_delete(struct CgiContext *cgi, struct PathSegment *segments,
+                int root) {
   json_object *module = NULL;
   json_object *top_level = NULL;
   char *module_name = NULL;
@@ -886,11 +1141,18 @@ int data_delete(struct CgiContext *cgi, char **pathvec, int root) {
   int retval = 1;
   struct UciPath uci = INIT_UCI_PATH();
   struct UciPath *delete = NULL;
-  char **package_list = NULL;
+  struct HashSet packages = INIT_HASH_SET();
   error err;
   char exists_path[512];
 
-  if (split_pair_by_char(pathvec[1], &module_name, &top_level_name, ':')) {
+  if (datastore_backend()->lock()) {
+    retval = print_error(INTERNAL);
+    goto done;
+  }
+
+  module_name = segments[1].module;
+  top_level_name = segments[1].name;
+  if (!module_name || segments[1].keys) {
     retval = restconf_badrequest();
     goto done;
   }
@@ -908,7 +1170,8 @@ int data_delete(struct CgiContext *cgi, char **pathvec, int root) {
   }
   get_path_from_yang(top_level, &uci);
 
-  err = check_path(&top_level, pathvec, 2, vector_size(pathvec), &uci, 1, 0);
+  err =
+      check_path(&top_level, segments, 2, vector_size(segments), &uci, 1, 0);
   if (!top_level || err != RE_OK) {
     retval = print_error(err);
     goto done;
@@ -929,22 +1192,23 @@ int data_delete(struct CgiContext *cgi, char **pathvec, int root) {
     goto done;
   }
   for (size_t i = 0; i < vector_size(delete); i++) {
-    char path_string[512];
-    struct UciPath tmp = delete[i];
-
-    uci_combine_to_path(&tmp, path_string, sizeof(path_string));
-
-    if (!is_in_vector(package_list, tmp.package)) {
-      vector_push_back(package_list, tmp.package);
-    }
-
-    if (uci_delete_path(path_string, false) == 1) {
+    if (hash_set_add(&packages, delete[i].package) < 0) {
       retval = print_error(INTERNAL);
-      uci_revert_all(package_list);
       goto done;
     }
   }
-  if (uci_commit_all(package_list)) {
+  if (delete_uci_path_list(delete) == 1) {
+    retval = print_error(INTERNAL);
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+  // a deleted value may still be referenced
+  if ((err = leafref_verify(packages.items)) != RE_OK) {
+    retval = print_error(err);
+    datastore_backend()->revert(packages.items);
+    goto done;
+  }
+  if (datastore_backend()->commit(packages.items)) {
     retval = restconf_partial_operation();
     goto done;
   }
@@ -955,8 +1219,6 @@ done:
   if (delete) {
     vector_free(delete);
   }
-  if (package_list) {
-    vector_free(package_list);
-  }
+  hash_set_free(&packages);
   return retval;
 }
\ No newline at end of file
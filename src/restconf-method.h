@@ -4,18 +4,15 @@
 #include "cgi.h"
 #include "error.h"
 #include "uci/methods.h"
+#include "url.h"
 
 typedef char** rvec;
 
-struct path_section_pair {
-  char* section_type;
-  int index;
-};
-
-int data_get(struct CgiContext* cgi, char** pathvec);
-int data_post(struct CgiContext* cgi, char** pathvec, int root);
-int data_delete(struct CgiContext* cgi, char** pathvec, int root);
-int data_put(struct CgiContext* cgi, char** pathvec, int root);
+int data_get(struct CgiContext* cgi, struct PathSegment* segments);
+int data_post(struct CgiContext* cgi, struct PathSegment* segments, int root);
+int data_delete(struct CgiContext* cgi, struct PathSegment* segments,
+                int root);
+int data_put(struct CgiContext* cgi, struct PathSegment* segments, int root);
 
 struct json_object* build_recursive(struct json_object* jobj,
                                     struct UciPath* path, error* err, int root);
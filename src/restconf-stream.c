@@ -0,0 +1,408 @@
+#include "restconf-stream.h"
+#include <string.h>
+#include "restconf-json.h"
+#include "uci/uci-util.h"
+#include "util.h"
+#include "vector.h"
+#include "yang-util.h"
+#include "yang-verify.h"
+
+/**
+ * Marks the section of writes in a list item whose leaf-as-name leaf or keys
+ * have not been read yet, compared by address
+ */
+static char pending_section[] = "";
+
+static UciWritePair **stream_value(struct ContentStream *stream,
+                                   enum json_token token,
+                                   struct json_object *yang,
+                                   struct UciPath *path,
+                                   UciWritePair **command_list, error *err);
+
+/**
+ * @brief add a write pair for a value
+ * @param command_list the list the write is appended to
+ * @param path the UCI path of the write
+ * @param value the value, it is copied
+ * @param type the type of the write
+ * @param err set to INTERNAL on error
+ * @return the command list
+ */
+static UciWritePair **push_write(UciWritePair **command_list,
+                                 struct UciPath *path, const char *value,
+                                 enum uci_object_type type, error *err) {
+  char *copy = NULL;
+  UciWritePair *output = NULL;
+  if (!(copy = str_dup(value)) ||
+      !(output = initialize_uci_write_pair(path, copy, type))) {
+    *err = INTERNAL;
+    return command_list;
+  }
+  vector_push_back(command_list, output);
+  return command_list;
+}
+
+/**
+ * @brief verify a leaf and create its write
+ * @param stream the content stream
+ * @param token the token of the value
+ * @param yang the YANG leaf node
+ * @param path the UCI path of the leaf
+ * @param command_list the list the write is appended to
+ * @param err set to the error in case of error
+ * @return the command list
+ */
+static UciWritePair **stream_leaf(struct ContentStream *stream,
+                                  enum json_token token,
+                                  struct json_object *yang,
+                                  struct UciPath *path,
+                                  UciWritePair **command_list, error *err) {
+  const char *value = json_stream_text(&stream->json);
+  if (!json_token_is_scalar(token)) {
+    *err = INVALID_TYPE;
+    return command_list;
+  }
+  if ((*err = yang_verify_leaf_value(value, yang)) != RE_OK) {
+    return command_list;
+  }
+  return push_write(command_list, path, value, option, err);
+}
+
+/**
+ * @brief verify a leaf-list and create the writes of its values
+ * A single value is accepted in place of an array.
+ * @param stream the content stream
+ * @param token the first token of the value
+ * @param yang the YANG leaf-list node
+ * @param path the UCI path of the leaf-list
+ * @param command_list the list the writes are appended to
+ * @param err set to the error in case of error
+ * @return the command list
+ */
+static UciWritePair **stream_leaf_list(struct ContentStream *stream,
+                                       enum json_token token,
+                                       struct json_object *yang,
+                                       struct UciPath *path,
+                                       UciWritePair **command_list,
+                                       error *err) {
+  struct HashSet seen = INIT_HASH_SET();
+  int array = token == JSON_TOKEN_ARRAY_START;
+  if (array && (token = json_stream_next(&stream->json)) ==
+                   JSON_TOKEN_ARRAY_END) {
+    return command_list;
+  }
+  while (1) {
+    const char *value = json_stream_text(&stream->json);
+    if (!json_token_is_scalar(token)) {
+      *err = token == JSON_TOKEN_ERROR ? MALFORMED_CONTENT : INVALID_TYPE;
+      break;
+    }
+    if ((*err = yang_verify_leaf_list_value(value, yang, &seen)) != RE_OK) {
+      break;
+    }
+    command_list = push_write(command_list, path, value, list, err);
+    if (*err != RE_OK || !array) {
+      break;
+    }
+    if ((token = json_stream_next(&stream->json)) == JSON_TOKEN_ARRAY_END) {
+      break;
+    } else if (token != JSON_TOKEN_COMMA) {
+      *err = MALFORMED_CONTENT;
+      break;
+    }
+    token = json_stream_next(&stream->json);
+  }
+  hash_set_free(&seen);
+  return command_list;
+}
+
+/**
+ * @brief verify the members of an object against the map of a YANG node
+ * A member may only occur once.
+ * @param stream the content stream
+ * @param token the first token of the value
+ * @param yang the YANG container or list node
+ * @param path the UCI path of the object
+ * @param command_list the list the writes are appended to
+ * @param err set to the error in case of error
+ * @param leaves if not NULL the scalar members are collected in it
+ * @return the command list
+ */
+static UciWritePair **stream_object(struct ContentStream *stream,
+                                    enum json_token token,
+                                    struct json_object *yang,
+                                    struct UciPath *path,
+                                    UciWritePair **command_list, error *err,
+                                    struct json_object *leaves) {
+  struct HashSet members = INIT_HASH_SET();
+  if (token != JSON_TOKEN_OBJECT_START) {
+    *err = token == JSON_TOKEN_ERROR ? MALFORMED_CONTENT : INVALID_TYPE;
+    return command_list;
+  }
+  if ((token = json_stream_next(&stream->json)) == JSON_TOKEN_OBJECT_END) {
+    return command_list;
+  }
+  while (1) {
+    struct json_object *child = NULL;
+    struct UciPath parent = *path;
+    const char *name = NULL;
+    char *key = NULL;
+    int added;
+    if (token != JSON_TOKEN_STRING) {
+      *err = MALFORMED_CONTENT;
+      break;
+    }
+    // members may be qualified with their module name
+    name = json_stream_text(&stream->json);
+    if (strchr(name, ':')) {
+      name = strchr(name, ':') + 1;
+    }
+    if (!(child = json_get_object_from_map(yang, name))) {
+      *err = NO_SUCH_ELEMENT;
+      break;
+    }
+    if (!(key = str_dup(name)) || (added = hash_set_add(&members, key)) < 0) {
+      *err = INTERNAL;
+      break;
+    }
+    if (!added || json_stream_next(&stream->json) != JSON_TOKEN_COLON) {
+      *err = MALFORMED_CONTENT;
+      break;
+    }
+    token = json_stream_next(&stream->json);
+    if (leaves && json_token_is_scalar(token)) {
+      json_object_object_add(
+          leaves, key,
+          json_object_new_string(json_stream_text(&stream->json)));
+    }
+    get_path_from_yang(child, path);
+    command_list =
+        stream_value(stream, token, child, path, command_list, err);
+    *path = parent;
+    if (*err != RE_OK) {
+      break;
+    }
+    if ((token = json_stream_next(&stream->json)) == JSON_TOKEN_OBJECT_END) {
+      break;
+    } else if (token != JSON_TOKEN_COMMA) {
+      *err = MALFORMED_CONTENT;
+      break;
+    }
+    token = json_stream_next(&stream->json);
+  }
+  hash_set_free(&members);
+  return command_list;
+}
+
+/**
+ * @brief verify one list item and create its writes
+ * The keys, unique and mandatory leaves of the item are checked once the item
+ * is complete. Only its scalar members are kept until then.
+ * @param stream the content stream
+ * @param token the first token of the item
+ * @param yang the YANG list node
+ * @param path the UCI path of the item
+ * @param command_list the list the writes are appended to
+ * @param err set to the error in case of error
+ * @param index the keys and unique values of the items before
+ * @return the command list
+ */
+static UciWritePair **stream_list_item(struct ContentStream *stream,
+                                       enum json_token token,
+                                       struct json_object *yang,
+                                       struct UciPath *path,
+                                       UciWritePair **command_list,
+                                       error *err, struct ListIndex *index) {
+  struct json_object *items = json_object_new_array();
+  struct json_object *leaves = json_object_new_object();
+  const char *leaf_as_name = json_get_string(yang, YANG_UCI_LEAF_AS_NAME);
+  const char *key_hash_name = json_get_string(yang, YANG_UCI_KEY_HASH_NAME);
+  const char *name = NULL;
+  char *section = path->section;
+  size_t first = vector_size(command_list);
+
+  json_object_array_add(items, leaves);
+  if (leaf_as_name || key_hash_name) {
+    path->section = pending_section;
+  }
+  command_list =
+      stream_object(stream, token, yang, path, command_list, err, leaves);
+  path->section = section;
+  if (*err != RE_OK) {
+    goto done;
+  }
+  if ((*err = json_yang_verify_list_indexed(items, yang, index)) != RE_OK) {
+    goto done;
+  }
+  if (key_hash_name) {
+    struct UciPath named = *path;
+    named.section = NULL;
+    if (get_key_hash_name(yang, leaves, &named)) {
+      *err = INTERNAL;
+      goto done;
+    }
+    name = named.section;
+  } else if (leaf_as_name) {
+    name = json_get_string(leaves, leaf_as_name);
+  }
+  if (name) {
+    if (hash_set_add(&stream->section_names, name) < 0) {
+      *err = INTERNAL;
+      goto done;
+    }
+    section = stream->section_names
+                  .items[hash_set_find(&stream->section_names, name)];
+  }
+  for (size_t i = first; i < vector_size(command_list); i++) {
+    if (command_list[i]->path.section == pending_section) {
+      command_list[i]->path.section = section;
+    }
+  }
+done:
+  json_object_put(items);
+  return command_list;
+}
+
+/**
+ * @brief verify a list and create the writes of its items
+ * @param stream the content stream
+ * @param token the first token of the value
+ * @param yang the YANG list node
+ * @param path the UCI path of the list
+ * @param command_list the list the writes are appended to
+ * @param err set to the error in case of error
+ * @return the command list
+ */
+static UciWritePair **stream_list(struct ContentStream *stream,
+                                  enum json_token token,
+                                  struct json_object *yang,
+                                  struct UciPath *path,
+                                  UciWritePair **command_list, error *err) {
+  struct ListIndex index = INIT_LIST_INDEX();
+  struct UciPath list_path = *path;
+  if (token != JSON_TOKEN_ARRAY_START) {
+    *err = token == JSON_TOKEN_ERROR ? MALFORMED_CONTENT : INVALID_TYPE;
+    return command_list;
+  }
+  if ((token = json_stream_next(&stream->json)) == JSON_TOKEN_ARRAY_END) {
+    return command_list;
+  }
+  path->where = 1;
+  while (1) {
+    command_list =
+        stream_list_item(stream, token, yang, path, command_list, err, &index);
+    if (*err != RE_OK) {
+      break;
+    }
+    if ((token = json_stream_next(&stream->json)) == JSON_TOKEN_ARRAY_END) {
+      break;
+    } else if (token != JSON_TOKEN_COMMA) {
+      *err = MALFORMED_CONTENT;
+      break;
+    }
+    token = json_stream_next(&stream->json);
+    path->index++;
+  }
+  list_index_free(&index);
+  *path = list_path;
+  return command_list;
+}
+
+/**
+ * @brief verify a value against a YANG node and create its writes
+ * @param stream the content stream
+ * @param token the first token of the value
+ * @param yang the YANG node
+ * @param path the UCI path of the value
+ * @param command_list the list the writes are appended to
+ * @param err set to the error in case of error
+ * @return the command list
+ */
+static UciWritePair **stream_value(struct ContentStream *stream,
+                                   enum json_token token,
+                                   struct json_object *yang,
+                                   struct UciPath *path,
+                                   UciWritePair **command_list, error *err) {
+  const char *type = NULL;
+  if (token == JSON_TOKEN_ERROR || token == JSON_TOKEN_END) {
+    *err = MALFORMED_CONTENT;
+    return command_list;
+  }
+  if (!(type = json_get_string(yang, YANG_TYPE))) {
+    *err = YANG_SCHEMA_ERROR;
+    return command_list;
+  }
+  if (yang_is_leaf_list(type)) {
+    return stream_leaf_list(stream, token, yang, path, command_list, err);
+  } else if (yang_is_leaf(type)) {
+    return stream_leaf(stream, token, yang, path, command_list, err);
+  } else if (yang_is_list(type)) {
+    return stream_list(stream, token, yang, path, command_list, err);
+  }
+  return stream_object(stream, token, yang, path, command_list, err, NULL);
+}
+
+/**
+ * @brief read the start of the body up to the value of its only member
+ * @param stream the content stream
+ * @param root_key set to the name of the member in the request arena
+ * @return MALFORMED_CONTENT if the body does not start with an object
+ */
+error content_stream_begin(struct ContentStream *stream, char **root_key) {
+  if (json_stream_next(&stream->json) != JSON_TOKEN_OBJECT_START ||
+      json_stream_next(&stream->json) != JSON_TOKEN_STRING) {
+    return MALFORMED_CONTENT;
+  }
+  if (!(*root_key = str_dup(json_stream_text(&stream->json)))) {
+    return INTERNAL;
+  }
+  if (json_stream_next(&stream->json) != JSON_TOKEN_COLON) {
+    return MALFORMED_CONTENT;
+  }
+  return RE_OK;
+}
+
+/**
+ * @brief verify the value of the root member while it is parsed
+ * The value is checked against the schema node by node and the writes are
+ * created directly, no JSON tree of the body is built. Parsing stops at the
+ * first invalid node.
+ * @param stream the content stream
+ * @param yang_node the YANG node of the value, it must be a container
+ * @param path the UCI path of the value
+ * @param err set to the error in case of error
+ * @return the command list, it has to be freed also in case of error
+ */
+UciWritePair **content_stream_verify(struct ContentStream *stream,
+                                     struct json_object *yang_node,
+                                     struct UciPath *path, error *err) {
+  enum json_token token = json_stream_next(&stream->json);
+  *err = RE_OK;
+  if (token != JSON_TOKEN_OBJECT_START) {
+    *err = MALFORMED_CONTENT;
+    return NULL;
+  }
+  return stream_value(stream, token, yang_node, path, NULL, err);
+}
+
+/**
+ * @brief read the end of the body after the value of the root member
+ * @param stream the content stream
+ * @return MALFORMED_CONTENT if anything but the end of the object follows
+ */
+error content_stream_end(struct ContentStream *stream) {
+  if (json_stream_next(&stream->json) != JSON_TOKEN_OBJECT_END ||
+      json_stream_next(&stream->json) != JSON_TOKEN_END) {
+    return MALFORMED_CONTENT;
+  }
+  return RE_OK;
+}
+
+/**
+ * @brief free the buffers and section names of a content stream
+ * @param stream the content stream
+ */
+void content_stream_free(struct ContentStream *stream) {
+  json_stream_free(&stream->json);
+  hash_set_free(&stream->section_names);
+}
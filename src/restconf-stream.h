@@ -0,0 +1,31 @@
+#ifndef RESTCONF_STREAM_H
+#define RESTCONF_STREAM_H
+
+#include <json-c/json.h>
+#include <stdio.h>
+#include "error.h"
+#include "hash-set.h"
+#include "json-stream.h"
+#include "uci/cmd.h"
+
+/**
+ * A request body that is verified against the YANG schema while it is parsed
+ * The section names taken from leaf-as-name leaves are kept in section_names
+ * since the write pairs point at them.
+ */
+struct ContentStream {
+  struct JsonStream json;
+  struct HashSet section_names;
+};
+
+#define INIT_CONTENT_STREAM(in, length) \
+  { INIT_JSON_STREAM((in), (length)), INIT_HASH_SET() }
+
+error content_stream_begin(struct ContentStream *stream, char **root_key);
+UciWritePair **content_stream_verify(struct ContentStream *stream,
+                                     struct json_object *yang_node,
+                                     struct UciPath *path, error *err);
+error content_stream_end(struct ContentStream *stream);
+void content_stream_free(struct ContentStream *stream);
+
+#endif  // RESTCONF_STREAM_H
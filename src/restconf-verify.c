@@ -1,34 +1,12 @@
+#include <uci/backend.h>
 #include <uci/cmd.h>
 #include <uci/uci-get.h>
 #include <uci/uci-util.h>
+#include "hash-set.h"
 #include "restconf-json.h"
 #include "vector.h"
 #include "yang-verify.h"
 
-/**
- * @brief verify a leaf list according to existence etc
- * @param value the leaf-list JSON array
- * @param path the UCI path pointing at that item
- * @param yang the YANG node for the leaf-list
- * @param check_exists check if node already exists
- * @return RE_OK if success else error
- */
-static error _restconf_verify_leaf_list(struct json_object *value,
-                                        struct UciPath *path,
-                                        struct json_object *yang,
-                                        int check_exists) {
-  error err;
-  if ((err = yang_verify_leaf_list(value, yang)) != RE_OK) {
-    return err;
-  }
-  if (check_exists) {
-    if (uci_element_exists(path)) {
-      return ELEMENT_ALREADY_EXISTS;
-    }
-  }
-  return RE_OK;
-}
-
 /**
  * @brief verify a leaf according to existence etc
  * @param value the leaf JSON object
@@ -51,12 +29,27 @@ error restconf_verify_leaf(struct json_object *value, struct UciPath *path,
   return RE_OK;
 }
 
+/**
+ * @brief verify leaf-list values and create the writes for them
+ * When check_exists is set the values are appended to the leaf-list. The
+ * values already in it are only indexed for duplicates, they are not
+ * validated or rewritten again.
+ * @param content the JSON value or array of values
+ * @param yang_node the YANG leaf-list node
+ * @param command_list the list the writes are appended to
+ * @param err set to the error in case of error
+ * @param check_exists append to the existing values instead of replacing
+ * @param path the UCI path pointing at the leaf-list
+ * @return the command list or NULL on error
+ */
 UciWritePair **restconf_verify_leaf_list(struct json_object *content,
                                          struct json_object *yang_node,
                                          UciWritePair **command_list,
                                          error *err, int check_exists,
                                          struct UciPath *path) {
-  struct json_object *existing_items = NULL;
+  struct HashSet seen = INIT_HASH_SET();
+  struct json_object *added = NULL;
+  enum uci_object_type write_type = check_exists ? list_append : list;
 
   json_type value_type = json_object_get_type(content);
   if (json_is_object(value_type)) {
@@ -64,36 +57,47 @@ UciWritePair **restconf_verify_leaf_list(struct json_object *content,
     return NULL;
   }
   if (check_exists) {
-    if (!(existing_items = uci_get_leaf_list(yang_node, path, err))) {
-      existing_items = json_object_new_array();
+    char path_string[512];
+    char **existing_items = NULL;
+    int failed = 0;
+    uci_combine_to_path(path, path_string, sizeof(path_string));
+    existing_items = datastore_backend()->read_list(path_string);
+    for (size_t i = 0; i < vector_size(existing_items); i++) {
+      if (hash_set_add(&seen, existing_items[i]) < 0) {
+        failed = 1;
+      }
+    }
+    vector_free(existing_items);
+    if (failed) {
+      *err = INTERNAL;
+      hash_set_free(&seen);
+      return NULL;
     }
-  } else {
-    existing_items = json_object_new_array();
-  }
-  if (*err != RE_OK && *err != UCI_READ_FAILED) {
-    return NULL;
   }
   if (json_is_array(value_type)) {
-    json_array_forloop(content, index) {
-      struct json_object *tmp = json_object_array_get_idx(content, index);
-      json_object_array_add(existing_items, tmp);
-    }
+    added = json_object_get(content);
   } else {
-    json_object_array_add(existing_items, content);
+    added = json_object_new_array();
+    json_object_array_add(added, json_object_get(content));
   }
-  if ((*err = _restconf_verify_leaf_list(existing_items, path, yang_node, 0)) !=
-      RE_OK) {
+  *err = yang_verify_leaf_list_indexed(added, yang_node, &seen);
+  hash_set_free(&seen);
+  if (*err != RE_OK) {
+    json_object_put(added);
     return NULL;
   }
-  json_array_forloop(existing_items, index) {
-    json_object *item = json_object_array_get_idx(existing_items, index);
+  json_array_forloop(added, index) {
+    json_object *item = json_object_array_get_idx(added, index);
     const char *value = json_object_get_string(item);
-    UciWritePair *output = initialize_uci_write_pair(path, (char *)value, list);
+    UciWritePair *output =
+        initialize_uci_write_pair(path, (char *)value, write_type);
     if (!output) {
       *err = INTERNAL;
+      json_object_put(added);
       return NULL;
     }
     vector_push_back(command_list, output);
   }
+  json_object_put(added);
   return command_list;
-}
\ No newline at end of file
+}
@@ -2,10 +2,15 @@
 #include <json-c/json.h>
 #include <stdio.h>
 #include <string.h>
+#include "arena.h"
 #include "cgi.h"
+#include "error.h"
 #include "http.h"
+#include "intern.h"
 #include "restconf-json.h"
 #include "restconf-method.h"
+#include "uci/uci-util.h"
+#include "url.h"
 #include "util.h"
 #include "vector.h"
 
@@ -33,12 +38,12 @@ static int api_root(struct CgiContext *cgi) {
 /**
  * @brief the data root method
  * @param cgi the cgi context
- * @param pathvec the path vector
+ * @param segments the path segments
  */
-static int data_root(struct CgiContext *cgi, char **pathvec) {
+static int data_root(struct CgiContext *cgi, struct PathSegment *segments) {
   int retval = 1;
 
-  if (pathvec[1] == NULL) {
+  if (vector_size(segments) < 2) {
     // root
     if (is_OPTIONS(cgi->method)) {
       content_type_json();
@@ -48,9 +53,9 @@ static int data_root(struct CgiContext *cgi, char **pathvec) {
     } else if (is_HEAD(cgi->method) || is_GET(cgi->method)) {
       retval = not_implemented(cgi);
     } else if (is_POST(cgi->method)) {
-      retval = data_post(cgi, pathvec, 1);
+      retval = data_post(cgi, segments, 1);
     } else if (is_PUT(cgi->method)) {
-      retval = data_put(cgi, pathvec, 1);
+      retval = data_put(cgi, segments, 1);
     } else {
       retval = not_found(cgi);
     }
@@ -58,13 +63,13 @@ static int data_root(struct CgiContext *cgi, char **pathvec) {
   }
 
   if (is_GET(cgi->method)) {
-    retval = data_get(cgi, pathvec);
+    retval = data_get(cgi, segments);
   } else if (is_POST(cgi->method)) {
-    retval = data_post(cgi, pathvec, 0);
+    retval = data_post(cgi, segments, 0);
   } else if (is_DELETE(cgi->method)) {
-    retval = data_delete(cgi, pathvec, 0);
+    retval = data_delete(cgi, segments, 0);
   } else if (is_PUT(cgi->method)) {
-    retval = data_put(cgi, pathvec, 0);
+    retval = data_put(cgi, segments, 0);
   } else {
     retval = not_found(cgi);
   }
@@ -73,15 +78,59 @@ done:
   return retval;
 }
 
+/**
+ * @brief the datastore root method (RFC 8527)
+ * @param cgi the cgi context
+ * @param segments the path segments starting with "ds"
+ */
+static int datastore_root(struct CgiContext *cgi,
+                          struct PathSegment *segments) {
+  if (vector_size(segments) < 2) {
+    return not_found(cgi);
+  }
+  if (path_segment_is(&segments[1], "ietf-datastores", "running")) {
+    uci_set_datastore(DATASTORE_RUNNING);
+  } else if (path_segment_is(&segments[1], "ietf-datastores", "candidate")) {
+    uci_set_datastore(DATASTORE_CANDIDATE);
+  } else {
+    return not_found(cgi);
+  }
+  // the datastore takes the place of "data" in the path
+  vector_erase(segments, 0);
+  return data_root(cgi, segments);
+}
+
 /**
  * @brief the operations root
  * @param cgi the cgi context
+ * @param segments the path segments
  */
-static int operations_root(struct CgiContext *cgi) {
-  content_type_json();
+static int operations_root(struct CgiContext *cgi,
+                           struct PathSegment *segments) {
+  if (vector_size(segments) < 2) {
+    content_type_json();
+    headers_end();
+
+    printf("Operations root\n");
+    return 0;
+  }
+  if (!is_POST(cgi->method)) {
+    return not_found(cgi);
+  }
+  if (path_segment_is(&segments[1], "ietf-netconf", "commit")) {
+    if (uci_commit_candidate()) {
+      return restconf_partial_operation();
+    }
+  } else if (path_segment_is(&segments[1], "ietf-netconf",
+                              "discard-changes")) {
+    if (uci_discard_candidate()) {
+      return restconf_operation_failed_internal();
+    }
+  } else {
+    return not_found(cgi);
+  }
+  printf("Status: 204 No Content\r\n");
   headers_end();
-
-  printf("Operations root\n");
   return 0;
 }
 
@@ -105,7 +154,9 @@ static int yang_library_version(struct CgiContext *cgi) {
 int main(void) {
   int retval = 1;
   char *path_modify = NULL;
-  char **vec = NULL;
+  // most paths fit, so they are parsed without allocating
+  vector_inline_storage(struct PathSegment, 8) segment_storage;
+  struct PathSegment *segments = NULL;
   struct CgiContext *ctx = NULL;
 
   ctx = cgi_context_init();
@@ -133,28 +184,36 @@ int main(void) {
 
   path_modify = str_dup(ctx->path);
 
-  if (!(vec = path2vec(path_modify, "/"))) {
+  vector_init_inline(segments, segment_storage);
+  if (path_parse(path_modify, &segments)) {
+    retval = restconf_malformed();
+    goto done;
+  }
+  if (vector_empty(segments)) {
     retval = not_found(ctx);
     goto done;
   }
 
-  if (strcmp(vec[0], "data") == 0) {
-    retval = data_root(ctx, vec);
-  } else if (strcmp(vec[0], "operations") == 0) {
-    retval = operations_root(ctx);
-  } else if (strcmp(vec[0], "yang-library-version") == 0) {
+  if (path_segment_is(&segments[0], NULL, "data")) {
+    retval = data_root(ctx, segments);
+  } else if (path_segment_is(&segments[0], NULL, "ds")) {
+    retval = datastore_root(ctx, segments);
+  } else if (path_segment_is(&segments[0], NULL, "operations")) {
+    retval = operations_root(ctx, segments);
+  } else if (path_segment_is(&segments[0], NULL, "yang-library-version")) {
     retval = yang_library_version(ctx);
   } else {
     retval = not_found(ctx);
   }
 
 done:
-  if (vec) {
-    vector_free(vec);
+  if (segments) {
+    vector_free(segments);
   }
   cgi_context_free(ctx);
-  if (path_modify) {
-    free(path_modify);
-  }
+  // changes of the request that were not committed are dropped
+  uci_request_savedir_release();
+  intern_release();
+  arena_release(request_arena());
   return retval;
 }
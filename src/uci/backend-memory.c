@@ -0,0 +1,509 @@
+#include <fcntl.h>
+#include <json-c/json.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include "arena.h"
+#include "uci/backend.h"
+#include "util.h"
+#include "vector.h"
+
+#ifdef RESTCONF_MEMORY_SEED
+#define MEMORY_SEED RESTCONF_MEMORY_SEED
+#else
+#define MEMORY_SEED NULL
+#endif
+
+#define MEMORY_TYPE ".type"
+#define MEMORY_ANONYMOUS ".anonymous"
+// the seed is written to a temporary file that replaces it, the lock file
+// serialises the requests that change it
+#define MEMORY_TEMP_SUFFIX ".tmp"
+#define MEMORY_LOCK_SUFFIX ".lock"
+
+/**
+ * A package of the in-memory datastore
+ */
+struct MemoryPackage {
+  char *name;
+  struct UciMap map;
+};
+
+// the names and values have to outlive the request arena
+static struct Arena store = INIT_ARENA();
+static struct MemoryPackage *packages = NULL;
+static int seeded = 0;
+static int lock_fd = -1;
+
+/**
+ * @brief find a package of the store
+ * @param name the name of the package
+ * @param create add the package if it does not exist
+ * @return the package or NULL
+ */
+static struct MemoryPackage *find_package(struct UciSlice name, int create) {
+  struct MemoryPackage added = {NULL, INIT_UCI_MAP()};
+
+  for (size_t i = 0; i < vector_size(packages); i++) {
+    if (uci_slice_is(name, packages[i].name)) {
+      return &packages[i];
+    }
+  }
+  if (!create ||
+      !(added.name = arena_strndup(&store, name.text, name.length))) {
+    return NULL;
+  }
+  vector_push_back(packages, added);
+  return &packages[vector_size(packages) - 1];
+}
+
+/**
+ * @brief apply a change to a package in the format of a saved delta
+ * The change is built in the store so the index can point into it.
+ * @param package the package
+ * @param command the command of the delta or 0 to set a value
+ * @param section the name of the section
+ * @param option the name of the option or none
+ * @param value the value or NULL
+ * @return 0 if success else 1
+ */
+static int memory_apply(struct MemoryPackage *package, char command,
+                        struct UciSlice section, struct UciSlice option,
+                        const char *value) {
+  size_t length = strlen(package->name) + 1 + section.length;
+  char *word = NULL;
+  int written;
+
+  length += option.text ? option.length + 1 : 0;
+  length += value ? strlen(value) + 1 : 0;
+  if (!(word = arena_alloc(&store, length + 1))) {
+    return 1;
+  }
+  written = snprintf(word, length + 1, "%s.%.*s", package->name,
+                     (int)section.length, section.text);
+  if (option.text) {
+    written += snprintf(word + written, length + 1 - written, ".%.*s",
+                        (int)option.length, option.text);
+  }
+  if (value) {
+    snprintf(word + written, length + 1 - written, "=%s", value);
+  }
+  return uci_map_apply(&package->map, command,
+                       (struct UciSlice){word, length}, package->name);
+}
+
+/**
+ * @brief read the sections of a package from its seed object
+ * @param package the package
+ * @param sections the seed object, its members are the named sections
+ * @return 0 if success else 1
+ */
+static int seed_package(struct MemoryPackage *package,
+                        struct json_object *sections) {
+  static const struct UciSlice none = {NULL, 0};
+
+  json_object_object_foreach(sections, name, section) {
+    struct UciSlice section_name = {name, strlen(name)};
+    struct json_object *type = NULL;
+    struct json_object *anonymous = NULL;
+
+    if (json_object_get_type(section) != json_type_object ||
+        !json_object_object_get_ex(section, MEMORY_TYPE, &type)) {
+      return 1;
+    }
+    json_object_object_get_ex(section, MEMORY_ANONYMOUS, &anonymous);
+    if (memory_apply(package, json_object_get_boolean(anonymous) ? '+' : 0,
+                     section_name, none, json_object_get_string(type))) {
+      return 1;
+    }
+    json_object_object_foreach(section, option, value) {
+      struct UciSlice option_name = {option, strlen(option)};
+      if (option[0] == '.') {
+        continue;
+      } else if (json_object_get_type(value) != json_type_array) {
+        if (memory_apply(package, 0, section_name, option_name,
+                         json_object_get_string(value))) {
+          return 1;
+        }
+        continue;
+      }
+      for (size_t i = 0; i < json_object_array_length(value); i++) {
+        if (memory_apply(package, '|', section_name, option_name,
+                         json_object_get_string(
+                             json_object_array_get_idx(value, i)))) {
+          return 1;
+        }
+      }
+    }
+  }
+  package->map.count = vector_size(package->map.sections);
+  return 0;
+}
+
+/**
+ * @brief (re)load packages from the seed
+ * A package that is not in the seed keeps its changes.
+ * @param only the name of the package to be loaded or NULL for all
+ * @return 0 if success else 1
+ */
+static int load_seed(const char *only) {
+  const char *path = MEMORY_SEED;
+  struct json_object *seed = NULL;
+  int retval = 0;
+
+  if (!path || !(seed = json_object_from_file(path))) {
+    return 0;
+  }
+  if (json_object_get_type(seed) != json_type_object) {
+    json_object_put(seed);
+    return 1;
+  }
+  json_object_object_foreach(seed, name, sections) {
+    struct UciSlice package_name = {name, strlen(name)};
+    struct MemoryPackage *package = NULL;
+    if (only && strcmp(only, name) != 0) {
+      continue;
+    }
+    if (!(package = find_package(package_name, 1)) ||
+        json_object_get_type(sections) != json_type_object) {
+      retval = 1;
+      break;
+    }
+    uci_map_free(&package->map);
+    if (seed_package(package, sections)) {
+      retval = 1;
+      break;
+    }
+  }
+  json_object_put(seed);
+  return retval;
+}
+
+static int memory_seed() {
+  if (!seeded) {
+    seeded = 1;
+    return load_seed(NULL);
+  }
+  return 0;
+}
+
+/**
+ * @brief release the lock of the seed
+ */
+static void memory_unlock() {
+  if (lock_fd >= 0) {
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+    lock_fd = -1;
+  }
+}
+
+/**
+ * @brief lock the seed before a write request is checked and reload it
+ * Every request runs in its own process, so the store only holds the seed
+ * and the changes of this request. The lock is held until the changes are
+ * committed or reverted, other requests that change the store wait for it
+ * and then check their changes against the seed this request wrote.
+ * @return 0 if success else 1
+ */
+static int memory_lock() {
+  const char *path = MEMORY_SEED;
+  char lock_path[512];
+
+  if (lock_fd >= 0 || !path) {
+    return memory_seed();
+  }
+  snprintf(lock_path, sizeof(lock_path), "%s%s", path, MEMORY_LOCK_SUFFIX);
+  if ((lock_fd = open(lock_path, O_RDWR | O_CREAT, 0600)) < 0) {
+    return 1;
+  }
+  if (flock(lock_fd, LOCK_EX)) {
+    close(lock_fd);
+    lock_fd = -1;
+    return 1;
+  }
+  // another request may have committed since the store was read
+  seeded = 1;
+  if (load_seed(NULL)) {
+    memory_unlock();
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief resolve a path against the store
+ * @param path the path
+ * @param parts set to the parsed path
+ * @param section set to the section or NULL
+ * @param option set to the option or NULL
+ * @return the package or NULL if it does not exist
+ */
+static struct MemoryPackage *memory_lookup(
+    char *path, struct UciMapPath *parts, const struct UciMapSection **section,
+    const struct UciMapOption **option) {
+  struct MemoryPackage *package = NULL;
+
+  *section = NULL;
+  *option = NULL;
+  if (memory_seed() || uci_map_parse_path(path, parts) ||
+      !(package = find_package(parts->package, 0))) {
+    return NULL;
+  }
+  uci_map_lookup(&package->map, parts, section, option);
+  return package;
+}
+
+static int memory_read_option(char *path, char *buffer, size_t size) {
+  struct UciMapPath parts;
+  const struct UciMapSection *section = NULL;
+  const struct UciMapOption *option = NULL;
+
+  if (!memory_lookup(path, &parts, &section, &option) || !option ||
+      option->list) {
+    return 1;
+  }
+  snprintf(buffer, size, "%.*s", (int)option->values[0].length,
+           option->values[0].text);
+  return 0;
+}
+
+static char **memory_read_list(char *path) {
+  struct UciMapPath parts;
+  const struct UciMapSection *section = NULL;
+  const struct UciMapOption *option = NULL;
+  char **values = NULL;
+
+  if (!memory_lookup(path, &parts, &section, &option) || !option) {
+    return NULL;
+  }
+  for (size_t i = 0; i < vector_size(option->values); i++) {
+    vector_push_back(values, uci_slice_dup(option->values[i]));
+  }
+  return values;
+}
+
+static int memory_sections(const char *name, struct UciMap *map) {
+  struct UciSlice package_name = {name, strlen(name)};
+  struct MemoryPackage *package = NULL;
+
+  *map = (struct UciMap)INIT_UCI_MAP();
+  if (memory_seed()) {
+    return 1;
+  }
+  if ((package = find_package(package_name, 0))) {
+    uci_map_copy(map, &package->map);
+  }
+  return 0;
+}
+
+/**
+ * @brief add anonymous sections until the one a path points at exists
+ * They are named cfg followed by hex digits like libuci names them, but the
+ * digits are taken from a count of the package instead of a hash.
+ * @param package the package
+ * @param parts the parsed path of the anonymous section
+ * @return 0 if success else 1
+ */
+static int reserve_sections(struct MemoryPackage *package,
+                            const struct UciMapPath *parts) {
+  static const struct UciSlice none = {NULL, 0};
+  char *type = uci_slice_dup(parts->type);
+  const struct UciMapSection **sections = NULL;
+  long count;
+
+  if (!type) {
+    return 1;
+  }
+  sections = uci_map_sections_of_type(&package->map, type);
+  count = (long)vector_size(sections);
+  vector_free(sections);
+  if (parts->index < -count) {
+    return 1;
+  }
+  for (; count <= parts->index; count++) {
+    char name[16];
+    struct UciSlice section_name = {name, 0};
+    do {
+      snprintf(name, sizeof(name), "cfg%02x%04x", package->map.count & 0xFF,
+               (package->map.count >> 8) & 0xFFFF);
+      package->map.count++;
+    } while (uci_map_section(&package->map, name));
+    section_name.length = strlen(name);
+    if (memory_apply(package, '+', section_name, none, type)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief set a path or add to a list in the store
+ * @param path the path
+ * @param value the value or section type
+ * @param command 0 to set the value or | to add it to a list
+ * @return 0 if success else 1
+ */
+static int memory_change(char *path, const char *value, char command) {
+  struct UciMapPath parts;
+  struct MemoryPackage *package = NULL;
+  long index;
+
+  if (memory_lock() || uci_map_parse_path(path, &parts) ||
+      (!parts.section.text && !parts.type.text) ||
+      (command && !parts.option.text) ||
+      !(package = find_package(parts.package, 1))) {
+    return 1;
+  }
+  if (parts.section.text) {
+    return memory_apply(package, command, parts.section, parts.option, value);
+  }
+  if (!parts.option.text && reserve_sections(package, &parts)) {
+    return 1;
+  }
+  if ((index = uci_map_find(&package->map, &parts)) < 0) {
+    return 1;
+  }
+  return memory_apply(package, command, package->map.sections[index].name,
+                      parts.option, value);
+}
+
+static int memory_set(char *path, const char *value) {
+  return memory_change(path, value, 0);
+}
+
+static int memory_add_list(char *path, const char *value) {
+  return memory_change(path, value, '|');
+}
+
+static int memory_delete(char *path) {
+  struct UciMapPath parts;
+  const struct UciMapSection *section = NULL;
+  const struct UciMapOption *option = NULL;
+  struct MemoryPackage *package = NULL;
+
+  if (memory_lock()) {
+    return 1;
+  }
+  package = memory_lookup(path, &parts, &section, &option);
+  if (!package || !section || (parts.option.text && !option)) {
+    return -1;
+  }
+  return memory_apply(package, '-', section->name,
+                      option ? option->name : parts.option, NULL);
+}
+
+/**
+ * @brief build the seed object of a package
+ * @param package the package
+ * @return the object
+ */
+static struct json_object *package_object(const struct MemoryPackage *package) {
+  struct json_object *sections = json_object_new_object();
+
+  for (size_t i = 0; i < vector_size(package->map.sections); i++) {
+    const struct UciMapSection *section = &package->map.sections[i];
+    struct json_object *object = json_object_new_object();
+    json_object_object_add(
+        object, MEMORY_TYPE,
+        json_object_new_string_len(section->type.text, section->type.length));
+    if (section->anonymous) {
+      json_object_object_add(object, MEMORY_ANONYMOUS,
+                             json_object_new_boolean(1));
+    }
+    for (size_t j = 0; j < vector_size(section->options); j++) {
+      const struct UciMapOption *option = &section->options[j];
+      struct json_object *value = NULL;
+      if (option->list) {
+        value = json_object_new_array();
+        for (size_t k = 0; k < vector_size(option->values); k++) {
+          json_object_array_add(
+              value, json_object_new_string_len(option->values[k].text,
+                                                option->values[k].length));
+        }
+      } else {
+        value = json_object_new_string_len(option->values[0].text,
+                                           option->values[0].length);
+      }
+      json_object_object_add(object, uci_slice_dup(option->name), value);
+    }
+    json_object_object_add(sections, uci_slice_dup(section->name), object);
+  }
+  return sections;
+}
+
+/**
+ * @brief write the store back to its seed and release the lock
+ * The seed is replaced as a whole, so a request that reads it concurrently
+ * sees it either before or after the commit. Without a seed the changes only
+ * last as long as the process.
+ * @param package_list the packages that were changed
+ * @return 0 if success else 1
+ */
+static int memory_commit(char **package_list) {
+  const char *path = MEMORY_SEED;
+  char temp_path[512];
+  struct json_object *seed = NULL;
+  int retval;
+
+  (void)package_list;
+  if (memory_seed()) {
+    return 1;
+  } else if (!path || lock_fd < 0) {
+    // nothing was changed since the last commit
+    return 0;
+  }
+  seed = json_object_new_object();
+  for (size_t i = 0; i < vector_size(packages); i++) {
+    json_object_object_add(seed, packages[i].name,
+                           package_object(&packages[i]));
+  }
+  snprintf(temp_path, sizeof(temp_path), "%s%s", path, MEMORY_TEMP_SUFFIX);
+  retval = json_object_to_file_ext(temp_path, seed,
+                                   JSON_C_TO_STRING_PRETTY) != 0 ||
+           rename(temp_path, path) != 0;
+  json_object_put(seed);
+  memory_unlock();
+  return retval;
+}
+
+/**
+ * @brief drop the changes of packages by reloading them from the seed
+ * A package that is not in the seed is emptied. The lock is released.
+ * @param package_list the packages to be reverted
+ * @return 0 if success else 1
+ */
+static int memory_revert(char **package_list) {
+  int retval = 0;
+
+  if (memory_seed()) {
+    return 1;
+  }
+  for (size_t i = 0; i < vector_size(package_list); i++) {
+    struct UciSlice name = {package_list[i], strlen(package_list[i])};
+    struct MemoryPackage *package = find_package(name, 0);
+    if (package) {
+      uci_map_free(&package->map);
+      package->map = (struct UciMap)INIT_UCI_MAP();
+    }
+    if (load_seed(package_list[i])) {
+      retval = 1;
+      break;
+    }
+  }
+  memory_unlock();
+  return retval;
+}
+
+const struct DatastoreBackend memory_backend = {
+    .name = "memory",
+    .read_option = memory_read_option,
+    .read_list = memory_read_list,
+    .sections = memory_sections,
+    .lock = memory_lock,
+    .set = memory_set,
+    .add_list = memory_add_list,
+    .delete = memory_delete,
+    .commit = memory_commit,
+    .revert = memory_revert};
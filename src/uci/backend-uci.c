@@ -0,0 +1,147 @@
+#include <string.h>
+#include <uci.h>
+#include "uci/backend.h"
+#include "uci/methods.h"
+#include "uci/uci-util.h"
+#include "util.h"
+#include "vector.h"
+
+/**
+ * @brief index a package of the selected datastore
+ * The configuration file is read in place. If it cannot be, libuci loads
+ * the package and it is indexed from there.
+ * @param package the name of the package
+ * @param map the index to be filled
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int uci_backend_sections(const char *package, struct UciMap *map) {
+  struct uci_ptr ptr;
+  struct uci_context *ctx = NULL;
+  char *dup_package = NULL;
+
+  if (uci_map_open(map, package) == 0) {
+    return 0;
+  }
+  if (!(ctx = uci_alloc_datastore_context())) {
+    return 1;
+  }
+  if ((dup_package = str_dup(package)) &&
+      uci_lookup_ptr(ctx, &ptr, dup_package, true) == UCI_OK && ptr.p) {
+    uci_map_from_package(map, ptr.p);
+  }
+  uci_free_context(ctx);
+  return 0;
+}
+
+/**
+ * @brief add anonymous sections until the one a path points at exists
+ * @param ctx the context holding the package snapshot
+ * @param package the name of the package
+ * @param parts the parsed path of the anonymous section
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int reserve_sections(struct uci_context *ctx, char *package,
+                            const struct UciMapPath *parts) {
+  struct uci_package *loaded = NULL;
+  struct uci_section **sections = NULL;
+  char *type = uci_slice_dup(parts->type);
+  long count;
+
+  if (!type) {
+    return 1;
+  }
+  sections = uci_context_sections_of_type(ctx, package, type, &loaded);
+  count = (long)vector_size(sections);
+  vector_free(sections);
+  if (!loaded || parts->index < -count) {
+    return 1;
+  }
+  for (; count <= parts->index; count++) {
+    if (!uci_add_section_anon(ctx, package, type)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief set a path or add to a list against a snapshot and save it
+ * @param path the path
+ * @param value the value or section type
+ * @param list add the value to a list instead of setting it
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int uci_backend_change(char *path, const char *value, int list) {
+  struct UciMapPath parts;
+  struct uci_ptr ptr;
+  struct uci_context *ctx = NULL;
+  char **package_list = NULL;
+  char *package = NULL;
+  char *dup_path = str_dup(path);
+  int failed = 1;
+
+  if (!dup_path || uci_map_parse_path(path, &parts) ||
+      !(package = uci_slice_dup(parts.package)) ||
+      (list && !parts.option.text) ||
+      !(ctx = uci_alloc_datastore_context())) {
+    return 1;
+  }
+  if (parts.type.text && !parts.option.text &&
+      reserve_sections(ctx, package, &parts)) {
+    goto done;
+  }
+  if (list) {
+    failed = uci_write_list(ctx, dup_path, value);
+  } else if (parts.option.text) {
+    failed = uci_write_option(ctx, dup_path, value);
+  } else if (uci_lookup_ptr(ctx, &ptr, dup_path, true) == UCI_OK) {
+    ptr.value = value;
+    failed = uci_set(ctx, &ptr) != UCI_OK;
+  }
+  vector_push_back(package_list, package);
+  failed = failed || uci_save_packages(ctx, package_list);
+done:
+  vector_free(package_list);
+  uci_free_context(ctx);
+  return failed;
+}
+
+static int uci_backend_set(char *path, const char *value) {
+  return uci_backend_change(path, value, 0);
+}
+
+static int uci_backend_add_list(char *path, const char *value) {
+  return uci_backend_change(path, value, 1);
+}
+
+static int uci_backend_delete(char *path) { return uci_delete_path(path); }
+
+/**
+ * @return 0, the changes of a request are saved to a delta directory of its
+ * own and only merged with the ones of others when they are published
+ */
+static int uci_backend_lock() { return 0; }
+
+const struct DatastoreBackend uci_backend = {
+    .name = "uci",
+    .read_option = uci_read_option,
+    .read_list = uci_read_list,
+    .sections = uci_backend_sections,
+    .lock = uci_backend_lock,
+    .set = uci_backend_set,
+    .add_list = uci_backend_add_list,
+    .delete = uci_backend_delete,
+    .commit = uci_commit_all,
+    .revert = uci_revert_all};
+
+/**
+ * @return the backend selected at build time, the in-memory backend is
+ * built in by giving it a seed
+ */
+const struct DatastoreBackend *datastore_backend() {
+#ifdef RESTCONF_MEMORY_SEED
+  return &memory_backend;
+#else
+  return &uci_backend;
+#endif
+}
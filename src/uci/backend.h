@@ -0,0 +1,39 @@
+#ifndef RESTCONF_BACKEND_H
+#define RESTCONF_BACKEND_H
+
+#include <stddef.h>
+#include "uci/uci-map.h"
+
+/**
+ * The operations the configuration is read and written through
+ * Paths are UCI paths, package.section.option or package.@type[index].option
+ * for an anonymous section. Setting a section path sets its type and adds the
+ * section if it is missing, package.@type[index] adds anonymous sections of
+ * the type up to the index. Changes are kept by the backend until they are
+ * committed or reverted.
+ */
+struct DatastoreBackend {
+  const char *name;
+  // copies the value of a string option into the buffer
+  int (*read_option)(char *path, char *buffer, size_t size);
+  // returns the values of an option in the request arena or NULL
+  char **(*read_list)(char *path);
+  // indexes the sections of a package, a missing one has no sections
+  int (*sections)(const char *package, struct UciMap *map);
+  // called by a write request before it reads what it checks its changes
+  // against, other write requests wait until this one commits or reverts
+  int (*lock)();
+  int (*set)(char *path, const char *value);
+  int (*add_list)(char *path, const char *value);
+  // returns 0 if deleted, -1 if it does not exist and 1 on error
+  int (*delete)(char *path);
+  int (*commit)(char **package_list);
+  int (*revert)(char **package_list);
+};
+
+extern const struct DatastoreBackend uci_backend;
+extern const struct DatastoreBackend memory_backend;
+
+const struct DatastoreBackend *datastore_backend();
+
+#endif  // RESTCONF_BACKEND_H
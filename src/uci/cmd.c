@@ -1,13 +1,24 @@
 #include "cmd.h"
 #include <util.h>
+#include "arena.h"
+#include "hash-set.h"
+#include "intern.h"
 #include "restconf-method.h"
+#include "uci/backend.h"
 #include "uci-util.h"
 #include "vector.h"
 
+/**
+ * creates a write pair in the request arena
+ * @param path the path of the write, it is copied
+ * @param value the value, it is not copied
+ * @param type the type of the write
+ * @return the write pair or NULL on error
+ */
 struct UciWritePair *initialize_uci_write_pair(struct UciPath *path,
                                                char *value,
                                                enum uci_object_type type) {
-  UciWritePair *output = malloc(sizeof(UciWritePair));
+  UciWritePair *output = arena_alloc(request_arena(), sizeof(UciWritePair));
   if (!output) {
     return NULL;
   }
@@ -17,88 +28,414 @@ struct UciWritePair *initialize_uci_write_pair(struct UciPath *path,
   return output;
 }
 
+/**
+ * frees a list of write pairs, the pairs themselves live in the request arena
+ * @param list the list
+ * @return 0
+ */
 int free_uci_write_list(UciWritePair **list) {
-  for (size_t i = 0; i < vector_size(list); i++) {
-    UciWritePair *cmd = list[i];
-    free(cmd->value);
-  }
   vector_free(list);
   return 0;
 }
 
-static int section_already_created(struct path_section_pair *sections,
-                                   char *section_type, int index) {
-  for (size_t i = 0; i < vector_size(sections); i++) {
-    struct path_section_pair curr = sections[i];
-    if (strcmp(curr.section_type, section_type) == 0 && curr.index == index) {
-      return 1;
+/**
+ * The anonymous sections of one type indexed by their position
+ */
+struct SectionIndex {
+  const char *package_name;
+  const char *type;
+  struct uci_package *package;
+  struct uci_section **sections;
+};
+
+/**
+ * returns the anonymous section a path points at and reserves all missing
+ * sections up to its position in one go
+ * The sections of a type are collected once per request so writes to them
+ * need no path lookups.
+ * @param ctx the context holding the package snapshot
+ * @param indexes the section indexes of the types seen so far
+ * @param path the interned path of the anonymous section
+ * @return the section or NULL on error
+ */
+static struct uci_section *reserve_anonymous_section(
+    struct uci_context *ctx, struct SectionIndex **indexes,
+    struct UciPath *path) {
+  struct SectionIndex *index = NULL;
+
+  for (size_t i = 0; i < vector_size(*indexes); i++) {
+    if ((*indexes)[i].package_name == path->package &&
+        (*indexes)[i].type == path->section_type) {
+      index = &(*indexes)[i];
+      break;
     }
   }
-  return 0;
+  if (!index) {
+    struct SectionIndex *vec = *indexes;
+    struct SectionIndex created = {path->package, path->section_type, NULL,
+                                   NULL};
+    created.sections = uci_context_sections_of_type(
+        ctx, path->package, path->section_type, &created.package);
+    if (!created.package) {
+      vector_free(created.sections);
+      return NULL;
+    }
+    vector_push_back(vec, created);
+    *indexes = vec;
+    index = &vec[vector_size(vec) - 1];
+  }
+  while (vector_size(index->sections) <= (size_t)path->index) {
+    struct uci_section *section =
+        uci_add_section_anon(ctx, path->package, path->section_type);
+    if (!section) {
+      return NULL;
+    }
+    vector_push_back(index->sections, section);
+  }
+  return index->sections[path->index];
 }
 
-static int leaf_list_deleted(struct UciPath *path, struct UciPath *comp) {
-  for (size_t i = 0; i < vector_size(path); i++) {
-    struct UciPath curr = path[i];
-    if (strcmp(curr.section_type, comp->section_type) == 0 &&
-        strcmp(curr.section, comp->section) == 0 &&
-        strcmp(curr.option, comp->option) == 0) {
-      return 1;
+/**
+ * applies the writes of a request one by one through a backend other than
+ * UCI without committing them
+ * Its sections are set before their options, anonymous sections are added
+ * up to the index of the write.
+ * @param backend the datastore backend
+ * @param write_list the list of writes to be applied
+ * @param packages the set the names of the modified packages are added to
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int write_backend_list(const struct DatastoreBackend *backend,
+                              UciWritePair **write_list,
+                              struct HashSet *packages) {
+  // resolved paths of the lists already cleared
+  struct HashSet cleared_lists = INIT_HASH_SET();
+  int retval = 1;
+
+  for (size_t i = 0; i < vector_size(write_list); i++) {
+    char section_string[512];
+    char path_string[512];
+    UciWritePair *cmd = write_list[i];
+    struct UciPath section = cmd->path;
+    int failed;
+    if (uci_path_intern(&cmd->path) ||
+        hash_set_add(packages, cmd->path.package) < 0) {
+      goto done;
+    }
+    section.option = "";
+    if (cmd->path.where &&
+        (cmd->path.section == NULL || strlen(cmd->path.section) == 0) &&
+        cmd->path.section_type) {
+      combine_to_anonymous_path(&section, section.index, section_string,
+                                sizeof(section_string));
+    } else if (cmd->path.section && strlen(cmd->path.section) > 0) {
+      combine_to_path(&section, section_string, sizeof(section_string));
+    } else {
+      // not addressable as a section, nothing to write
+      continue;
+    }
+    if (backend->set(section_string, cmd->path.section_type)) {
+      goto done;
+    }
+    if (cmd->type == container) {
+      continue;
+    }
+    uci_combine_to_path(&cmd->path, path_string, sizeof(path_string));
+    if (cmd->type == list) {
+      int added = hash_set_add(&cleared_lists, path_string);
+      if (added < 0 || (added && backend->delete(path_string) == 1)) {
+        goto done;
+      }
+    }
+    if (cmd->type != option) {
+      failed = backend->add_list(path_string, cmd->value);
+    } else {
+      failed = backend->set(path_string, cmd->value);
+    }
+    if (failed) {
+      goto done;
     }
   }
-  return 0;
+  retval = 0;
+done:
+  hash_set_free(&cleared_lists);
+  return retval;
 }
 
-int write_uci_write_list(UciWritePair **write_list) {
-  struct path_section_pair *section_list = NULL;
-  struct UciPath *path = NULL;
+/**
+ * applies all writes of a request against one snapshot of the packages
+ * and saves every modified package once, the writes are committed by the
+ * commit of the backend
+ * @param write_list the list of writes to be applied
+ * @param packages the set the names of the modified packages are added to
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int write_uci_write_list(UciWritePair **write_list, struct HashSet *packages) {
+  struct SectionIndex *section_indexes = NULL;
+  // resolved paths of the lists already cleared
+  struct HashSet cleared_lists = INIT_HASH_SET();
+  // the packages modified by this write list
+  struct HashSet modified = INIT_HASH_SET();
+  int retval = 1;
+  struct uci_context *ctx = NULL;
+  if (datastore_backend() != &uci_backend) {
+    return write_backend_list(datastore_backend(), write_list, packages);
+  }
+  if (!(ctx = uci_alloc_datastore_context())) {
+    return 1;
+  }
   for (size_t i = 0; i < vector_size(write_list); i++) {
     int failed = 1;
     char local_path_string[512];
+    struct uci_section *section = NULL;
     UciWritePair *cmd = write_list[i];
-    if ((cmd->path.where && cmd->path.section == NULL) && cmd->path.section_type) {
-      int section_exists = section_already_created(
-          section_list, cmd->path.section_type, cmd->path.index);
-      snprintf(local_path_string, sizeof(local_path_string), "%s.@%s[%d]",
-               cmd->path.package, cmd->path.section_type, cmd->path.index);
-      section_exists = section_exists || uci_path_exists(local_path_string);
-      if (!section_exists) {
-        uci_add_section_anon(cmd->path.package, cmd->path.section_type);
-        struct path_section_pair output = {
-            .section_type = cmd->path.section_type, .index = cmd->path.index};
-        vector_push_back(section_list, output);
+    if (uci_path_intern(&cmd->path) ||
+        hash_set_add(&modified, cmd->path.package) < 0 ||
+        hash_set_add(packages, cmd->path.package) < 0) {
+      goto done;
+    }
+    if (cmd->path.where &&
+        (cmd->path.section == NULL || strlen(cmd->path.section) == 0) &&
+        cmd->path.section_type) {
+      if (!(section = reserve_anonymous_section(ctx, &section_indexes,
+                                                &cmd->path))) {
+        goto done;
       }
       combine_to_anonymous_path(&cmd->path, cmd->path.index, local_path_string,
                                 sizeof(local_path_string));
-    } else {
-      uci_add_section_named(cmd->path.package, cmd->path.section_type,
-                            cmd->path.section);
+    } else if (cmd->path.section && strlen(cmd->path.section) > 0) {
+      if (uci_add_section_named(ctx, cmd->path.package,
+                                cmd->path.section_type, cmd->path.section)) {
+        goto done;
+      }
       combine_to_path(&cmd->path, local_path_string, sizeof(local_path_string));
+    } else {
+      // not addressable as a section, nothing to write
+      continue;
     }
-    if (cmd->type == list && !leaf_list_deleted(path, &cmd->path)) {
-      char *duplicated_local_path_string = str_dup(local_path_string);
-      if (!duplicated_local_path_string) {
-        return 1;
+    if (cmd->type == container) {
+      // the section has been created above
+      continue;
+    }
+    if (cmd->type == list) {
+      int added = hash_set_add(&cleared_lists, local_path_string);
+      int deleted = -1;
+      if (added < 0) {
+        goto done;
+      }
+      if (added && section) {
+        deleted = uci_section_delete_option(ctx, section, cmd->path.option);
+      } else if (added) {
+        deleted = uci_context_delete_path(ctx, local_path_string);
+      }
+      if (deleted == 1) {
+        goto done;
       }
-      uci_delete_path(duplicated_local_path_string, 1);
-      free(duplicated_local_path_string);
-      vector_push_back(path, cmd->path);
-    }
-    switch (cmd->type) {
-      case list:
-        failed = uci_write_list(local_path_string, cmd->value);
-        break;
-      case option:
-        failed = uci_write_option(local_path_string, cmd->value);
-        break;
-      case container:
-        failed = uci_add_section_named(
-            cmd->path.package, cmd->path.section_type, cmd->path.section);
-        break;
+    }
+    if (section) {
+      failed = uci_section_write(ctx, section, cmd->path.option, cmd->value,
+                                 cmd->type != option);
+    } else if (cmd->type != option) {
+      failed = uci_write_list(ctx, local_path_string, cmd->value);
+    } else {
+      failed = uci_write_option(ctx, local_path_string, cmd->value);
     }
     if (failed) {
-      // TODO: Discard delta
+      // nothing has been saved yet, dropping the context discards the delta
+      goto done;
+    }
+  }
+  retval = uci_save_packages(ctx, modified.items);
+done:
+  uci_free_context(ctx);
+  for (size_t i = 0; i < vector_size(section_indexes); i++) {
+    vector_free(section_indexes[i].sections);
+  }
+  vector_free(section_indexes);
+  hash_set_free(&cleared_lists);
+  hash_set_free(&modified);
+  return retval;
+}
+
+/**
+ * checks if a path removes every section of its type
+ * @param path the path to be checked
+ * @return 1 if it does else 0
+ */
+static int is_section_type_delete(struct UciPath *path) {
+  return !path->where && strlen(path->section) == 0 &&
+         strlen(path->section_type) > 0 && strlen(path->option) == 0;
+}
+
+/**
+ * checks if two interned paths address the same section
+ */
+static int same_section(struct UciPath *a, struct UciPath *b) {
+  if (a->package != b->package) {
+    return 0;
+  }
+  if (strlen(a->section) > 0 || strlen(b->section) > 0) {
+    return a->section == b->section;
+  }
+  if (a->where && b->where) {
+    return a->index == b->index && a->section_type == b->section_type;
+  }
+  if (a->where || b->where) {
+    return 0;
+  }
+  return a->section == b->section;
+}
+
+/**
+ * checks if a path is already removed by a delete in the plan
+ * The paths are interned, so their names are compared by address.
+ * @param plan the planned deletes
+ * @param path the path to be checked
+ * @return 1 if it is else 0
+ */
+static int delete_covered(struct UciPath *plan, struct UciPath *path) {
+  for (size_t i = 0; i < vector_size(plan); i++) {
+    struct UciPath *planned = &plan[i];
+    if (planned->package != path->package) {
+      continue;
+    }
+    if (is_section_type_delete(planned)) {
+      if (planned->section_type == path->section_type) {
+        return 1;
+      }
+      continue;
+    }
+    if (!same_section(planned, path)) {
+      continue;
+    }
+    if (strlen(planned->option) == 0 || planned->option == path->option) {
+      return 1;
     }
   }
   return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * collapses the extracted paths into the smallest set of deletes
+ * Whole lists are removed by section type, sections before their options.
+ * @param delete_list the paths of all removed nodes, they are interned
+ * @param err set to 1 if a path cannot be interned
+ * @return vector of the planned deletes
+ */
+static struct UciPath *plan_uci_deletes(struct UciPath *delete_list,
+                                        int *err) {
+  struct UciPath *plan = NULL;
+  for (size_t i = 0; i < vector_size(delete_list); i++) {
+    if (uci_path_intern(&delete_list[i])) {
+      *err = 1;
+      return NULL;
+    }
+  }
+  for (int pass = 0; pass < 3; pass++) {
+    for (size_t i = 0; i < vector_size(delete_list); i++) {
+      struct UciPath *path = &delete_list[i];
+      int path_pass = 2;
+      if (is_section_type_delete(path)) {
+        path_pass = 0;
+      } else if (strlen(path->option) == 0) {
+        path_pass = 1;
+      }
+      if (path_pass != pass || delete_covered(plan, path)) {
+        continue;
+      }
+      vector_push_back(plan, *path);
+    }
+  }
+  return plan;
+}
+
+/**
+ * removes the planned paths through a backend other than UCI
+ * All sections of a type are removed by removing the first one until none
+ * is left.
+ * @param backend the datastore backend
+ * @param plan the planned deletes
+ * @return 0 if something was deleted, -1 if nothing existed and 1 on error
+ */
+static int delete_backend_plan(const struct DatastoreBackend *backend,
+                               struct UciPath *plan) {
+  int retval = -1;
+  for (size_t i = 0; i < vector_size(plan); i++) {
+    struct UciPath *path = &plan[i];
+    char path_string[512];
+    int deleted;
+    if (is_section_type_delete(path)) {
+      combine_to_anonymous_path(path, 0, path_string, sizeof(path_string));
+      while ((deleted = backend->delete(path_string)) == 0) {
+        retval = 0;
+      }
+    } else if (path->where || strlen(path->section) > 0) {
+      uci_combine_to_path(path, path_string, sizeof(path_string));
+      deleted = backend->delete(path_string);
+    } else {
+      continue;
+    }
+    if (deleted == 1) {
+      return 1;
+    } else if (deleted == 0) {
+      retval = 0;
+    }
+  }
+  return retval;
+}
+
+/**
+ * removes the paths against one snapshot and saves every modified package
+ * once, the deletes are committed by the commit of the backend
+ * @param delete_list the paths to be removed
+ * @return 0 if something was deleted, -1 if nothing existed and 1 on error
+ */
+int delete_uci_path_list(struct UciPath *delete_list) {
+  int err = 0;
+  struct UciPath *plan = plan_uci_deletes(delete_list, &err);
+  struct HashSet packages = INIT_HASH_SET();
+  int retval = -1;
+  struct uci_context *ctx = NULL;
+  if (!err && datastore_backend() != &uci_backend) {
+    retval = delete_backend_plan(datastore_backend(), plan);
+    vector_free(plan);
+    return retval;
+  }
+  if (err || !(ctx = uci_alloc_datastore_context())) {
+    vector_free(plan);
+    return 1;
+  }
+  for (size_t i = 0; i < vector_size(plan); i++) {
+    struct UciPath *path = &plan[i];
+    int deleted;
+    if (is_section_type_delete(path)) {
+      deleted = uci_context_delete_sections(ctx, path->package,
+                                            path->section_type);
+    } else if (path->where || strlen(path->section) > 0) {
+      char path_string[512];
+      uci_combine_to_path(path, path_string, sizeof(path_string));
+      deleted = uci_context_delete_path(ctx, path_string);
+    } else {
+      continue;
+    }
+    if (deleted == 1) {
+      retval = 1;
+      goto done;
+    }
+    if (deleted == 0) {
+      retval = 0;
+      if (hash_set_add(&packages, path->package) < 0) {
+        retval = 1;
+        goto done;
+      }
+    }
+  }
+  if (uci_save_packages(ctx, packages.items)) {
+    retval = 1;
+  }
+done:
+  uci_free_context(ctx);
+  vector_free(plan);
+  hash_set_free(&packages);
+  return retval;
+}
@@ -1,9 +1,11 @@
 #ifndef RESTCONF_CMD_H
 #define RESTCONF_CMD_H
 
+#include "hash-set.h"
 #include "methods.h"
 
-enum uci_object_type { list, option, container };
+// list_append adds to a leaf-list without replacing its current values
+enum uci_object_type { list, list_append, option, container };
 
 struct UciWritePair {
   struct UciPath path;
@@ -15,7 +17,8 @@ typedef struct UciWritePair UciWritePair;
 struct UciWritePair *initialize_uci_write_pair(struct UciPath *path,
                                                char *value,
                                                enum uci_object_type type);
-int write_uci_write_list(UciWritePair **write_list);
+int write_uci_write_list(UciWritePair **write_list, struct HashSet *packages);
 int free_uci_write_list(UciWritePair **list);
+int delete_uci_path_list(struct UciPath *delete_list);
 
 #endif  // RESTCONF_CMD_H
@@ -1,11 +1,103 @@
 #include "methods.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <stdio.h>
 #include <string.h>
 #include <uci.h>
+#include <unistd.h>
 #include "http.h"
+#include "uci/backend.h"
 #include "uci-util.h"
 #include "util.h"
 #include "vector.h"
 
+static enum uci_datastore selected_datastore = DATASTORE_RUNNING;
+static char request_savedir[64];
+
+/**
+ * removes the delta files in a directory
+ * @param savedir the delta directory
+ */
+static void remove_deltas(const char *savedir) {
+  char path[512];
+  struct dirent *entry = NULL;
+  DIR *dir = opendir(savedir);
+  if (!dir) {
+    return;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s/%s", savedir, entry->d_name);
+    unlink(path);
+  }
+  closedir(dir);
+}
+
+/**
+ * returns the delta directory private to this request
+ * Changes are saved there and only published to the shared delta directory
+ * of the datastore when the request commits, so reverting a failed request
+ * never touches the changes of another one.
+ * @return the directory
+ */
+const char *uci_request_savedir() {
+  if (!request_savedir[0]) {
+    snprintf(request_savedir, sizeof(request_savedir), "%s-%ld",
+             RESTCONF_REQUEST_SAVEDIR, (long)getpid());
+    // left behind by an earlier process with the same id
+    remove_deltas(request_savedir);
+  }
+  return request_savedir;
+}
+
+/**
+ * drops the uncommitted changes of this request and its delta directory
+ */
+void uci_request_savedir_release() {
+  if (!request_savedir[0]) {
+    return;
+  }
+  remove_deltas(request_savedir);
+  rmdir(request_savedir);
+  request_savedir[0] = '\0';
+}
+
+/**
+ * selects the datastore all following operations are run against
+ * @param datastore the datastore
+ */
+void uci_set_datastore(enum uci_datastore datastore) {
+  selected_datastore = datastore;
+}
+
+/**
+ * @return the selected datastore
+ */
+enum uci_datastore uci_get_datastore() { return selected_datastore; }
+
+/**
+ * allocates a uci context for the selected datastore
+ * The candidate datastore keeps its changes in its own delta directory
+ * which is only merged into the configuration on an explicit commit.
+ * Changes saved through the context go to the delta directory of the request.
+ * @return the context or NULL
+ */
+struct uci_context *uci_alloc_datastore_context() {
+  struct uci_context *ctx = uci_alloc_context();
+  if (!ctx) {
+    return NULL;
+  }
+  if ((selected_datastore == DATASTORE_CANDIDATE &&
+       uci_set_savedir(ctx, RESTCONF_CANDIDATE_SAVEDIR) != UCI_OK) ||
+      uci_set_savedir(ctx, uci_request_savedir()) != UCI_OK) {
+    uci_free_context(ctx);
+    return NULL;
+  }
+  return ctx;
+}
+
 /**
  * reads a uci option into a buffer by path
  * @param path the path to be used
@@ -14,7 +106,7 @@
  */
 int uci_read_option(char *path, char *buffer, size_t size) {
   struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
+  struct uci_context *ctx = uci_alloc_datastore_context();
   if (!ctx) {
     return 1;
   }
@@ -43,7 +135,7 @@ int uci_read_option(char *path, char *buffer, size_t size) {
 char **uci_read_list(char *path) {
   struct uci_ptr ptr;
   char **ret = NULL;
-  struct uci_context *ctx = uci_alloc_context();
+  struct uci_context *ctx = uci_alloc_datastore_context();
   if (!ctx) {
     return NULL;
   }
@@ -56,243 +148,377 @@ char **uci_read_list(char *path) {
     return NULL;
   }
 
-  if (ptr.flags & UCI_LOOKUP_COMPLETE) {
+  if ((ptr.flags & UCI_LOOKUP_COMPLETE) && ptr.o->type == UCI_TYPE_LIST) {
     struct uci_element *e;
     uci_foreach_element(&ptr.o->v.list, e) {
       vector_push_back(ret, str_dup(e->name));
     }
+  } else if (ptr.flags & UCI_LOOKUP_COMPLETE) {
+    vector_push_back(ret, str_dup(ptr.o->v.string));
   }
   uci_free_context(ctx);
   return ret;
 }
 
+/**
+ * checks if the section or option of a path exists in the selected backend
+ * @param path the path to be checked
+ * @return 1 if it exists else 0
+ */
 int uci_path_exists(char *path) {
-  struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
-  if (!ctx) {
-    return 0;
-  }
-  char *path_dup = str_dup(path);
-  if (!path_dup) {
+  struct UciMapPath parts;
+  struct UciMap map = INIT_UCI_MAP();
+  const struct UciMapSection *section = NULL;
+  const struct UciMapOption *option = NULL;
+  char *package = NULL;
+  int exists = 0;
+
+  if (uci_map_parse_path(path, &parts) ||
+      !(package = uci_slice_dup(parts.package)) ||
+      datastore_backend()->sections(package, &map)) {
     return 0;
   }
+  exists = uci_map_lookup(&map, &parts, &section, &option);
+  uci_map_free(&map);
+  return exists;
+}
 
-  unsigned int UCI_LOOKUP_COMPLETE = (1u << 1u);
-
-  if ((uci_lookup_ptr(ctx, &ptr, path_dup, true) != UCI_OK) ||
-      (ptr.s == NULL && ptr.o == NULL)) {
-    uci_free_context(ctx);
-    free(path_dup);
+/**
+ * checks if a named section of the section type of a path exists
+ * The section is looked up by its name, no section of the type is read.
+ * @param path the path with the package, section name and section type
+ * @return 1 if it exists else 0
+ */
+int uci_named_section_exists(struct UciPath *path) {
+  struct UciMap map = INIT_UCI_MAP();
+  const struct UciMapSection *section = NULL;
+  int exists = 0;
+
+  // a name that is not a valid section name could be read as a path
+  for (const char *c = path->section; *c; c++) {
+    if (!isalnum((unsigned char)*c) && *c != '_') {
+      return 0;
+    }
+  }
+  if (!*path->section || datastore_backend()->sections(path->package, &map)) {
     return 0;
   }
-
-  uci_free_context(ctx);
-  free(path_dup);
-
-  return ptr.flags & UCI_LOOKUP_COMPLETE;
+  if ((section = uci_map_section(&map, path->section))) {
+    exists = uci_slice_is(section->type, path->section_type);
+  }
+  uci_map_free(&map);
+  return exists;
 }
 
+/**
+ * finds the first entry of a list whose options hold the given values
+ * @param where the path of the list and the option values
+ * @return the index of the entry or -1 if there is none
+ */
 int uci_index_where(struct UciWhere *where) {
-  int index = 0;
-  char *package = str_dup(where->path->package);
-  char *section_type = str_dup(where->path->section_type);
-  struct UciPath path = {.package = package,
-                         .section_type = section_type,
-                         .section = "",
-                         .option = "",
-                         .index = 0,
-                         .where = 0};
-  while (1) {
-    int notfound = 0;
-    for (int i = 0; i < where->key_value_length; i++) {
-      char path_string[512];
-      char buf[512];
-      path.option = (char *)where->key_value[i].key;
-      combine_to_anonymous_path(&path, index, path_string, sizeof(path_string));
-      if (uci_read_option(path_string, buf, sizeof(buf))) {
-        index = -1;
-        break;
-      }
-      if (strcmp(buf, where->key_value[i].str) != 0) {
-        notfound = 1;
-        break;
-      }
+  struct UciMap map = INIT_UCI_MAP();
+  const struct UciMapSection **sections = NULL;
+  int index = -1;
+
+  if (datastore_backend()->sections(where->path->package, &map)) {
+    return -1;
+  }
+  sections = uci_map_sections_of_type(&map, where->path->section_type);
+  for (size_t i = 0; i < vector_size(sections) && index < 0; i++) {
+    int found = 1;
+    for (int j = 0; j < where->key_value_length && found; j++) {
+      struct UciMapOption *option =
+          uci_map_option(sections[i], where->key_value[j].key);
+      found = option && !option->list &&
+              uci_slice_is(option->values[0], where->key_value[j].str);
     }
-    if (!notfound) {
-      break;
+    if (found) {
+      index = (int)i;
     }
-    index++;
   }
-  free(package);
-  free(section_type);
+  vector_free(sections);
+  uci_map_free(&map);
   return index;
 }
 
-int uci_write_option(char *path, const char *value) {
+/**
+ * sets a uci option inside an open context without committing it
+ * @param ctx the context holding the package snapshot
+ * @param path the path of the option
+ * @param value the value to be set
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_write_option(struct uci_context *ctx, char *path, const char *value) {
   struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
-  if (!ctx) {
-    return 1;
-  }
 
   if (uci_lookup_ptr(ctx, &ptr, path, true) != UCI_OK) {
-    uci_free_context(ctx);
     return 1;
   }
 
   ptr.value = value;
   if ((uci_set(ctx, &ptr) != UCI_OK) ||
       (ptr.o == NULL || ptr.o->v.string == NULL)) {
-    uci_free_context(ctx);
     return 1;
   }
-  uci_commit(ctx, &ptr.p, false);
-
-  uci_free_context(ctx);
   return 0;
 }
 
-int uci_write_list(char *path, const char *value) {
+/**
+ * appends a value to a uci list inside an open context without committing it
+ * @param ctx the context holding the package snapshot
+ * @param path the path of the list
+ * @param value the value to be appended
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_write_list(struct uci_context *ctx, char *path, const char *value) {
   struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
-  if (!ctx) {
-    return 1;
-  }
 
   if (uci_lookup_ptr(ctx, &ptr, path, true) != UCI_OK) {
-    uci_free_context(ctx);
     return 1;
   }
 
   ptr.value = value;
   if ((uci_add_list(ctx, &ptr) != UCI_OK) ||
       (ptr.o == NULL || ptr.o->v.string == NULL)) {
-    uci_free_context(ctx);
     return 1;
   }
-  uci_commit(ctx, &ptr.p, false);
-
-  uci_free_context(ctx);
   return 0;
 }
 
 int uci_list_length(struct UciPath *path) {
-  int index = 0;
+  struct UciMap map = INIT_UCI_MAP();
+  const struct UciMapSection **sections = NULL;
+  int length;
   if (!path->package || !path->section_type) {
     return -1;
   }
-  char *package = str_dup(path->package);
-  char *section_type = str_dup(path->section_type);
-  if (!package || !section_type) {
+  if (datastore_backend()->sections(path->package, &map)) {
     return -1;
   }
-  struct UciPath cloned_path = {.section = "",
-                                .package = package,
-                                .section_type = section_type,
-                                .index = 0,
-                                .where = 0,
-                                .option = ""};
-
-  while (1) {
-    char path_string[512];
-    combine_to_anonymous_path(&cloned_path, index, path_string,
-                              sizeof(path_string));
-    struct uci_ptr ptr;
-    struct uci_context *ctx = uci_alloc_context();
-    if (!ctx) {
-      return -1;
-    }
+  sections = uci_map_sections_of_type(&map, path->section_type);
+  length = vector_size(sections);
+  vector_free(sections);
+  uci_map_free(&map);
+  return length;
+}
 
-    unsigned int UCI_LOOKUP_COMPLETE = (1u << 1u);
+/**
+ * collects the sections of a type in one pass over the package
+ * @param ctx the context holding the package snapshot
+ * @param package_name the name of the package
+ * @param type the section type
+ * @param package set to the loaded package or NULL if it does not exist
+ * @return vector of the sections in the order of the package
+ */
+struct uci_section **uci_context_sections_of_type(struct uci_context *ctx,
+                                                  char *package_name,
+                                                  const char *type,
+                                                  struct uci_package **package) {
+  struct uci_ptr ptr;
+  struct uci_element *e = NULL;
+  struct uci_section **sections = NULL;
+  char *dup_package = NULL;
 
-    if ((uci_lookup_ptr(ctx, &ptr, path_string, true) != UCI_OK)) {
-      uci_free_context(ctx);
-      break;
+  *package = NULL;
+  if (!(dup_package = str_dup(package_name))) {
+    return NULL;
+  }
+  if ((uci_lookup_ptr(ctx, &ptr, dup_package, true) != UCI_OK) ||
+      ptr.p == NULL) {
+    return NULL;
+  }
+  uci_foreach_element(&ptr.p->sections, e) {
+    struct uci_section *section = uci_to_section(e);
+    if (strcmp(section->type, type) == 0) {
+      vector_push_back(sections, section);
     }
+  }
+  *package = ptr.p;
+  return sections;
+}
 
-    if (!(ptr.flags & UCI_LOOKUP_COMPLETE)) {
-      uci_free_context(ctx);
-      break;
-    }
-    uci_free_context(ctx);
-    index++;
+/**
+ * sets or appends to an option of a section without a path lookup
+ * @param ctx the context holding the package snapshot
+ * @param section the section of the option
+ * @param option the name of the option
+ * @param value the value
+ * @param append append to a list instead of setting the option
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_section_write(struct uci_context *ctx, struct uci_section *section,
+                      const char *option, const char *value, int append) {
+  struct uci_ptr ptr;
+  memset(&ptr, 0, sizeof(ptr));
+  ptr.p = section->package;
+  ptr.s = section;
+  ptr.o = uci_lookup_option(ctx, section, option);
+  ptr.package = section->package->e.name;
+  ptr.section = section->e.name;
+  ptr.option = option;
+  ptr.value = value;
+  if (append) {
+    return uci_add_list(ctx, &ptr) != UCI_OK;
   }
+  return uci_set(ctx, &ptr) != UCI_OK;
+}
 
-  free(package);
-  free(section_type);
-  return index;
+/**
+ * deletes an option of a section without a path lookup
+ * @param ctx the context holding the package snapshot
+ * @param section the section of the option
+ * @param option the name of the option
+ * @return 0 if deleted, -1 if it does not exist and 1 on error
+ */
+int uci_section_delete_option(struct uci_context *ctx,
+                              struct uci_section *section,
+                              const char *option) {
+  struct uci_ptr ptr;
+  memset(&ptr, 0, sizeof(ptr));
+  if (!(ptr.o = uci_lookup_option(ctx, section, option))) {
+    return -1;
+  }
+  ptr.p = section->package;
+  ptr.s = section;
+  ptr.package = section->package->e.name;
+  ptr.section = section->e.name;
+  ptr.option = option;
+  return uci_delete(ctx, &ptr) != UCI_OK;
 }
 
-struct uci_section *uci_add_section_anon(char *package_name, char *type) {
+struct uci_section *uci_add_section_anon(struct uci_context *ctx,
+                                        char *package_name, char *type) {
   struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
-  if (!ctx) {
+  struct uci_section *section = NULL;
+  char *dup_package = NULL;
+
+  if (!(dup_package = str_dup(package_name))) {
     return NULL;
   }
-  if ((uci_lookup_ptr(ctx, &ptr, package_name, true) != UCI_OK)) {
-    uci_free_context(ctx);
+  if ((uci_lookup_ptr(ctx, &ptr, dup_package, true) != UCI_OK) ||
+      ptr.p == NULL) {
     return NULL;
   }
-  struct uci_section *section = NULL;
-  uci_add_section(ctx, ptr.p, type, &section);
-  uci_commit(ctx, &ptr.p, false);
-
-  uci_free_context(ctx);
+  if (uci_add_section(ctx, ptr.p, type, &section) != UCI_OK) {
+    section = NULL;
+  }
   return section;
 }
 
-int uci_add_section_named(char *package_name, const char *type, char *name) {
+int uci_add_section_named(struct uci_context *ctx, char *package_name,
+                          const char *type, char *name) {
   struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
-  if (!ctx) {
-    return 1;
-  }
   char path_string[512];
   snprintf(path_string, sizeof(path_string), "%s.%s", package_name, name);
   if ((uci_lookup_ptr(ctx, &ptr, path_string, true) != UCI_OK)) {
-    uci_free_context(ctx);
     return 1;
   }
   ptr.value = type;
-  uci_set(ctx, &ptr);
-  uci_commit(ctx, &ptr.p, false);
-
-  uci_free_context(ctx);
+  if (uci_set(ctx, &ptr) != UCI_OK) {
+    return 1;
+  }
   return 0;
 }
 
-int uci_revert_package(char *package) {
+/**
+ * deletes a path inside an open context without saving or committing it
+ * @param ctx the context holding the package snapshot
+ * @param path the path to be deleted
+ * @return 0 if deleted, -1 if it does not exist and 1 on error
+ */
+int uci_context_delete_path(struct uci_context *ctx, char *path) {
   struct uci_ptr ptr;
-  struct uci_context *ctx = uci_alloc_context();
-  if (!ctx) {
-    return 1;
-  }
+  char *dup_path = NULL;
 
   unsigned int UCI_LOOKUP_COMPLETE = (1u << 1u);
 
-  if ((uci_lookup_ptr(ctx, &ptr, package, true) != UCI_OK) || (ptr.p == NULL)) {
-    uci_free_context(ctx);
+  if (!(dup_path = str_dup(path))) {
     return 1;
   }
-
-  if (!(ptr.flags & UCI_LOOKUP_COMPLETE)) {
-    uci_free_context(ctx);
+  if ((uci_lookup_ptr(ctx, &ptr, dup_path, true) != UCI_OK) ||
+      (ptr.o == NULL && ptr.s == NULL) ||
+      !(ptr.flags & UCI_LOOKUP_COMPLETE)) {
+    return -1;
+  }
+  if (uci_delete(ctx, &ptr) != UCI_OK) {
     return 1;
   }
+  return 0;
+}
 
-  if (uci_revert(ctx, &ptr)) {
-    uci_free_context(ctx);
+/**
+ * deletes all sections of a type in one pass over the package without saving
+ * or committing it
+ * @param ctx the context holding the package snapshot
+ * @param package_name the name of the package
+ * @param type the section type to be deleted
+ * @return 0 if deleted, -1 if no section of that type exists and 1 on error
+ */
+int uci_context_delete_sections(struct uci_context *ctx, char *package_name,
+                                const char *type) {
+  struct uci_ptr ptr;
+  struct uci_element *e = NULL;
+  struct uci_element *tmp = NULL;
+  char *dup_package = NULL;
+  int retval = -1;
+
+  if (!(dup_package = str_dup(package_name))) {
     return 1;
   }
+  if ((uci_lookup_ptr(ctx, &ptr, dup_package, true) != UCI_OK) ||
+      ptr.p == NULL) {
+    return -1;
+  }
+  uci_foreach_element_safe(&ptr.p->sections, tmp, e) {
+    struct uci_section *section = uci_to_section(e);
+    struct uci_ptr section_ptr;
+    if (strcmp(section->type, type) != 0) {
+      continue;
+    }
+    memset(&section_ptr, 0, sizeof(section_ptr));
+    section_ptr.p = ptr.p;
+    section_ptr.s = section;
+    section_ptr.package = ptr.p->e.name;
+    section_ptr.section = section->e.name;
+    if (uci_delete(ctx, &section_ptr) != UCI_OK) {
+      retval = 1;
+      break;
+    }
+    retval = 0;
+  }
+  return retval;
+}
 
-  uci_free_context(ctx);
+/**
+ * writes the pending changes of the packages into the delta directory
+ * @param ctx the context holding the package snapshot
+ * @param package_list the vector of package names that were modified
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_save_packages(struct uci_context *ctx, char **package_list) {
+  for (size_t i = 0; i < vector_size(package_list); i++) {
+    struct uci_ptr ptr;
+    char *dup_package = NULL;
+    if (!(dup_package = str_dup(package_list[i]))) {
+      return 1;
+    }
+    if ((uci_lookup_ptr(ctx, &ptr, dup_package, true) != UCI_OK) ||
+        ptr.p == NULL || uci_save(ctx, ptr.p) != UCI_OK) {
+      return 1;
+    }
+  }
   return 0;
 }
 
-int uci_delete_path(char *path, int commit) {
+/**
+ * deletes a path and saves the change without committing it
+ * @param path the path to be deleted
+ * @return 0 if deleted, -1 if it does not exist and 1 on error
+ */
+int uci_delete_path(char *path) {
   struct uci_ptr ptr;
   char *dup_path = NULL;
-  struct uci_context *ctx = uci_alloc_context();
+  struct uci_context *ctx = uci_alloc_datastore_context();
   if (!ctx) {
     return 1;
   }
@@ -300,37 +526,38 @@ int uci_delete_path(char *path, int commit) {
   unsigned int UCI_LOOKUP_COMPLETE = (1u << 1u);
 
   if (!(dup_path = str_dup(path))) {
+    uci_free_context(ctx);
     return 1;
   }
   if ((uci_lookup_ptr(ctx, &ptr, dup_path, true) != UCI_OK) ||
       (ptr.o == NULL && ptr.s == NULL)) {
-    free(dup_path);
     uci_free_context(ctx);
     return -1;
   }
 
   if (!(ptr.flags & UCI_LOOKUP_COMPLETE)) {
-    free(dup_path);
     uci_free_context(ctx);
     return -1;
   }
 
   if (uci_delete(ctx, &ptr)) {
-    free(dup_path);
     uci_free_context(ctx);
     return 1;
   }
 
-  if (commit) {
-    uci_commit(ctx, &ptr.p, false);
-  } else {
-    uci_save(ctx, ptr.p);
+  if (uci_save(ctx, ptr.p) != UCI_OK) {
+    uci_free_context(ctx);
+    return 1;
   }
-  free(dup_path);
   uci_free_context(ctx);
   return 0;
 }
 
+/**
+ * commits the deltas published to the shared delta directory of a package
+ * @param package the name of the package
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
 int uci_commit_package(char *package) {
   struct uci_ptr ptr;
   struct uci_context *ctx = uci_alloc_context();
@@ -350,6 +577,12 @@ int uci_commit_package(char *package) {
     return 1;
   }
 
+  if (!ptr.p->has_delta) {
+    // already written by a commit of another request
+    uci_free_context(ctx);
+    return 0;
+  }
+
   if (uci_commit(ctx, &ptr.p, false)) {
     uci_free_context(ctx);
     return 1;
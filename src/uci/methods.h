@@ -17,6 +17,14 @@ struct UciPath {
   int index;
 };
 
+/**
+ * The datastores that can be addressed (RFC 8342)
+ */
+enum uci_datastore { DATASTORE_RUNNING, DATASTORE_CANDIDATE };
+
+#define RESTCONF_CANDIDATE_SAVEDIR "/tmp/.restconf-candidate"
+#define RESTCONF_REQUEST_SAVEDIR "/tmp/.restconf-request"
+
 struct UciWhere {
   struct UciPath *path;
   map_str2str *key_value;
@@ -26,17 +34,36 @@ struct UciWhere {
 #define INIT_UCI_PATH() \
   { "", "", "", "", 0, 0 }
 
+void uci_set_datastore(enum uci_datastore datastore);
+enum uci_datastore uci_get_datastore();
+const char *uci_request_savedir();
+void uci_request_savedir_release();
+struct uci_context *uci_alloc_datastore_context();
 int uci_read_option(char *path, char *buffer, size_t size);
 char **uci_read_list(char *path);
 int uci_path_exists(char *path);
+int uci_named_section_exists(struct UciPath *path);
 int uci_index_where(struct UciWhere *where);
-int uci_write_option(char *path, const char *value);
-int uci_write_list(char *path, const char *value);
+int uci_write_option(struct uci_context *ctx, char *path, const char *value);
+int uci_write_list(struct uci_context *ctx, char *path, const char *value);
 int uci_list_length(struct UciPath *path);
-struct uci_section *uci_add_section_anon(char *package_name, char *type);
-int uci_add_section_named(char *package_name, const char *type, char *name);
-int uci_revert_package(char *package);
-int uci_delete_path(char *path, int commit);
+struct uci_section **uci_context_sections_of_type(struct uci_context *ctx,
+                                                  char *package_name,
+                                                  const char *type,
+                                                  struct uci_package **package);
+int uci_section_write(struct uci_context *ctx, struct uci_section *section,
+                      const char *option, const char *value, int append);
+int uci_section_delete_option(struct uci_context *ctx,
+                              struct uci_section *section, const char *option);
+struct uci_section *uci_add_section_anon(struct uci_context *ctx,
+                                        char *package_name, char *type);
+int uci_add_section_named(struct uci_context *ctx, char *package_name,
+                          const char *type, char *name);
+int uci_context_delete_path(struct uci_context *ctx, char *path);
+int uci_context_delete_sections(struct uci_context *ctx, char *package_name,
+                                const char *type);
+int uci_save_packages(struct uci_context *ctx, char **package_list);
+int uci_delete_path(char *path);
 int uci_commit_package(char *package);
 
 #endif  //_YANG_UCI_H
@@ -0,0 +1,214 @@
+#include "uci/uci-emit.h"
+#include <inttypes.h>
+#include <string.h>
+#include "json-writer.h"
+#include "uci/backend.h"
+#include "util.h"
+#include "vector.h"
+
+/**
+ * @brief index a package of the selected backend for writing it
+ * A package that does not exist is written as if it had no sections.
+ * @param emit the emitter
+ * @param out the output
+ * @param package the name of the package
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_emit_init(struct UciEmit *emit, FILE *out, char *package) {
+  memset(emit, 0, sizeof(*emit));
+  emit->out = out;
+  emit->entry = -1;
+  return datastore_backend()->sections(package, &emit->map);
+}
+
+/**
+ * @brief free the package snapshot of an emitter
+ * @param emit the emitter
+ */
+void uci_emit_free(struct UciEmit *emit) { uci_map_free(&emit->map); }
+
+/**
+ * @brief look up a named section of the package
+ * @param emit the emitter
+ * @param name the name of the section
+ * @return the section or NULL if it does not exist
+ */
+const struct UciMapSection *uci_emit_section(struct UciEmit *emit,
+                                             const char *name) {
+  return uci_map_section(&emit->map, name);
+}
+
+/**
+ * @brief start a member of an open object or array
+ * @param emit the emitter
+ * @param level the level of the object or array
+ * @param key the key or NULL for an array item
+ */
+static void member_start(struct UciEmit *emit, int level, const char *key) {
+  fputs(emit->members[level]++ ? "," : "", emit->out);
+  json_write_indent(emit->out, level + 1);
+  if (key) {
+    fputs(key, emit->out);
+  }
+}
+
+/**
+ * @brief write the objects and arrays that were opened but not written yet
+ * @param emit the emitter
+ */
+static void flush(struct UciEmit *emit) {
+  for (; emit->opened < emit->depth; emit->opened++) {
+    int level = emit->opened;
+    if (level > 0) {
+      member_start(emit, level - 1, emit->keys[level]);
+    }
+    fputc(emit->closing[level] == '}' ? '{' : '[', emit->out);
+  }
+}
+
+/**
+ * @brief open an object or array, it is written with its first member
+ * @param emit the emitter
+ * @param key the key or NULL for an array item
+ * @param open '{' for an object or '[' for an array
+ */
+void uci_emit_open(struct UciEmit *emit, const char *key, char open) {
+  emit->keys[emit->depth] = key;
+  emit->closing[emit->depth] = open == '{' ? '}' : ']';
+  emit->members[emit->depth] = 0;
+  emit->depth++;
+}
+
+/**
+ * @brief close the innermost object or array
+ * @param emit the emitter
+ * @param flags UCI_EMIT_KEEP_EMPTY to write it even without members
+ * @return 1 if it was written else 0
+ */
+int uci_emit_close(struct UciEmit *emit, int flags) {
+  int level = emit->depth - 1;
+  if (level >= emit->opened) {
+    if (!(flags & UCI_EMIT_KEEP_EMPTY)) {
+      emit->depth--;
+      return 0;
+    }
+    flush(emit);
+  }
+  if (emit->members[level] == 0) {
+    fputc(' ', emit->out);
+  } else {
+    json_write_indent(emit->out, level);
+  }
+  fputc(emit->closing[level], emit->out);
+  emit->depth--;
+  emit->opened = emit->depth;
+  return 1;
+}
+
+/**
+ * @brief write a value of a leaf in the member that was started
+ * @param emit the emitter
+ * @param value the value of the option
+ * @param number write the value as integer instead of as string
+ */
+static void write_value(struct UciEmit *emit, struct UciSlice value,
+                        int number) {
+  if (number) {
+    // the value is not terminated in the mapped file
+    char digits[32];
+    size_t length =
+        value.length < sizeof(digits) ? value.length : sizeof(digits) - 1;
+    memcpy(digits, value.text, length);
+    digits[length] = '\0';
+    fprintf(emit->out, "%" PRId32, (int32_t)strtoimax(digits, NULL, 10));
+  } else {
+    json_write_string(emit->out, value.text, value.length);
+  }
+}
+
+/**
+ * @brief write a leaf, nothing is written if its option is not set
+ * @param emit the emitter
+ * @param key the key of the leaf
+ * @param section the section of the option
+ * @param option the name of the option
+ * @param number write the value as integer instead of as string
+ */
+void uci_emit_leaf(struct UciEmit *emit, const char *key,
+                   const struct UciMapSection *section, const char *option,
+                   int number) {
+  struct UciMapOption *o = uci_map_option(section, option);
+  if (!o || o->list) {
+    return;
+  }
+  flush(emit);
+  member_start(emit, emit->depth - 1, key);
+  write_value(emit, o->values[0], number);
+}
+
+/**
+ * @brief write a leaf-list, an option that is not a list is one item
+ * @param emit the emitter
+ * @param key the key of the leaf-list
+ * @param section the section of the option
+ * @param option the name of the option
+ * @param number write the values as integers instead of as strings
+ */
+void uci_emit_leaf_list(struct UciEmit *emit, const char *key,
+                        const struct UciMapSection *section,
+                        const char *option, int number) {
+  struct UciMapOption *o = uci_map_option(section, option);
+  if (!o) {
+    return;
+  }
+  uci_emit_open(emit, key, '[');
+  flush(emit);
+  for (size_t i = 0; i < vector_size(o->values); i++) {
+    member_start(emit, emit->depth - 1, NULL);
+    write_value(emit, o->values[i], number);
+  }
+  uci_emit_close(emit, UCI_EMIT_KEEP_EMPTY);
+}
+
+/**
+ * @brief open the array of a list and get the sections of its entries
+ * A list without entries is written as { } if it is kept. The entry that is
+ * selected by the entry or selected field is the only one returned.
+ * @param emit the emitter
+ * @param key the key of the list
+ * @param type the section type of the entries
+ * @param flags UCI_EMIT_KEEP_EMPTY to keep a list without entries
+ * @return the sections of the entries or NULL if the array was not opened
+ */
+const struct UciMapSection **uci_emit_list_open(struct UciEmit *emit,
+                                                const char *key,
+                                                const char *type, int flags) {
+  const struct UciMapSection **sections = NULL;
+  const struct UciMapSection *selected = emit->selected;
+  int entry = emit->entry;
+
+  emit->entry = -1;
+  emit->selected = NULL;
+  for (size_t i = 0; !selected && i < vector_size(emit->map.sections); i++) {
+    if (uci_slice_is(emit->map.sections[i].type, type)) {
+      vector_push_back(sections, &emit->map.sections[i]);
+    }
+  }
+  if (!selected && entry >= 0) {
+    selected =
+        entry < (int)vector_size(sections) ? sections[entry] : NULL;
+    vector_free(sections);
+    sections = NULL;
+  }
+  if (selected) {
+    vector_push_back(sections, selected);
+  }
+  if (vector_empty(sections)) {
+    vector_free(sections);
+    uci_emit_open(emit, key, '{');
+    uci_emit_close(emit, flags);
+    return NULL;
+  }
+  uci_emit_open(emit, key, '[');
+  return sections;
+}
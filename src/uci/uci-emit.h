@@ -0,0 +1,48 @@
+#ifndef RESTCONF_UCI_EMIT_H
+#define RESTCONF_UCI_EMIT_H
+
+#include <stdio.h>
+#include "uci/uci-map.h"
+
+#define UCI_EMIT_MAX_DEPTH 32
+
+// an object without members is written as { } instead of being dropped
+#define UCI_EMIT_KEEP_EMPTY 1
+
+/**
+ * Writes the configuration of a package snapshot as indented JSON in the
+ * format of json_write_pretty
+ * Objects and arrays are only written once their first member is, so empty
+ * ones can still be dropped. The keys are written as given, they are
+ * escaped and followed by ": " already. The package is read through the
+ * index the datastore backend builds of it.
+ */
+struct UciEmit {
+  FILE *out;
+  struct UciMap map;
+  int entry;
+  const struct UciMapSection *selected;
+  int depth;
+  int opened;
+  const char *keys[UCI_EMIT_MAX_DEPTH];
+  char closing[UCI_EMIT_MAX_DEPTH];
+  int members[UCI_EMIT_MAX_DEPTH];
+};
+
+int uci_emit_init(struct UciEmit *emit, FILE *out, char *package);
+void uci_emit_free(struct UciEmit *emit);
+const struct UciMapSection *uci_emit_section(struct UciEmit *emit,
+                                             const char *name);
+void uci_emit_open(struct UciEmit *emit, const char *key, char open);
+int uci_emit_close(struct UciEmit *emit, int flags);
+void uci_emit_leaf(struct UciEmit *emit, const char *key,
+                   const struct UciMapSection *section, const char *option,
+                   int number);
+void uci_emit_leaf_list(struct UciEmit *emit, const char *key,
+                        const struct UciMapSection *section,
+                        const char *option, int number);
+const struct UciMapSection **uci_emit_list_open(struct UciEmit *emit,
+                                                const char *key,
+                                                const char *type, int flags);
+
+#endif  // RESTCONF_UCI_EMIT_H
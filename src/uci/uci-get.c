@@ -1,15 +1,177 @@
 #include "cmd.h"
 #include "error.h"
+#include "hash-set.h"
 #include "http.h"
 #include "restconf-json.h"
 #include "restconf-method.h"
+#include "uci/backend.h"
 #include "uci/uci-util.h"
+#include "util.h"
 #include "vector.h"
 #include "yang-util.h"
 
+/**
+ * A leaf of a list entry that is read straight from its option
+ */
+struct ListLeaf {
+  yang_type type;
+  int leaf_list;
+};
+
+/**
+ * Maps the options of a list entry section to the leaves of the list
+ * The position of an option in the set is the one of its leaf in leaves.
+ */
+struct ListRenderer {
+  struct HashSet options;
+  struct ListLeaf *leaves;
+  long *children;
+};
+
+#define INIT_LIST_RENDERER() \
+  { INIT_HASH_SET(), NULL, NULL }
+
+static void list_renderer_free(struct ListRenderer *renderer) {
+  hash_set_free(&renderer->options);
+  vector_free(renderer->leaves);
+  vector_free(renderer->children);
+}
+
+/**
+ * @brief map the option names of the leaves of a list to the leaves
+ * Children that are no plain leaves with an option are marked with -1 and
+ * read by build_recursive.
+ * @param map the map of the YANG list node
+ * @param renderer the renderer to be filled
+ * @return 0 if success else 1
+ */
+static int list_renderer_init(struct json_object *map,
+                              struct ListRenderer *renderer) {
+  json_object_object_foreach(map, key, val) {
+    struct ListLeaf leaf = {NONE, 0};
+    struct json_object *leaf_type = NULL;
+    const char *type = json_get_string(val, YANG_TYPE);
+    const char *option = json_get_string(val, YANG_UCI_OPTION);
+    long child = -1;
+    int added;
+    (void)key;
+
+    if (type && option && !json_get_string(val, YANG_UCI_PACKAGE) &&
+        !json_get_string(val, YANG_UCI_SECTION) &&
+        !json_get_string(val, YANG_UCI_SECTION_NAME) &&
+        (yang_is_leaf(type) || yang_is_leaf_list(type)) &&
+        json_object_object_get_ex(val, YANG_LEAF_TYPE, &leaf_type)) {
+      leaf.leaf_list = yang_is_leaf_list(type);
+      leaf.type = json_extract_yang_type(leaf_type);
+      if (leaf.type == NONE && !leaf.leaf_list) {
+        leaf.type = STRING;
+      }
+      if ((added = hash_set_add(&renderer->options, option)) < 0) {
+        return 1;
+      }
+      // two leaves of one option are left to the generic walk
+      if (added) {
+        child = vector_size(renderer->leaves);
+        vector_push_back(renderer->leaves, leaf);
+      }
+    }
+    vector_push_back(renderer->children, child);
+  }
+  return 0;
+}
+
+/**
+ * @brief format a value of an option of a list entry
+ * @param type the type of the leaf
+ * @param value the value
+ * @return the JSON value or NULL if it is no value of the type
+ */
+static struct json_object *list_value(yang_type type, struct UciSlice value) {
+  char *copy = uci_slice_dup(value);
+  return copy ? json_yang_type_format(type, copy) : NULL;
+}
+
+/**
+ * @brief format the value of an option of a list entry
+ * @param leaf the leaf of the option
+ * @param o the option
+ * @return the JSON value or NULL if the option has no value for the leaf
+ */
+static struct json_object *list_leaf_value(const struct ListLeaf *leaf,
+                                           const struct UciMapOption *o) {
+  struct json_object *output = NULL;
+
+  if (!leaf->leaf_list) {
+    return o->list ? NULL : list_value(leaf->type, o->values[0]);
+  }
+  if (leaf->type == NONE) {
+    return NULL;
+  }
+  output = json_object_new_array();
+  for (size_t i = 0; i < vector_size(o->values); i++) {
+    struct json_object *item = list_value(leaf->type, o->values[i]);
+    if (!item) {
+      break;
+    }
+    json_object_array_add(output, item);
+  }
+  return output;
+}
+
+/**
+ * @brief build a list entry in one pass over the options of its section
+ * The values are placed in the order of the schema, children that are not
+ * indexed are read by build_recursive.
+ * @param renderer the renderer of the list
+ * @param map the map of the YANG list node
+ * @param section the section of the entry or NULL if it does not exist
+ * @param path the path of the entry
+ * @return the entry
+ */
+static struct json_object *list_render_entry(struct ListRenderer *renderer,
+                                             struct json_object *map,
+                                             const struct UciMapSection *section,
+                                             struct UciPath *path) {
+  size_t count = vector_size(renderer->leaves);
+  struct json_object *values[count ? count : 1];
+  struct json_object *entry = json_object_new_object();
+  size_t position = 0;
+
+  memset(values, 0, sizeof(values));
+  for (size_t i = 0; section && i < vector_size(section->options); i++) {
+    const struct UciMapOption *o = &section->options[i];
+    char name[o->name.length + 1];
+    long found;
+    memcpy(name, o->name.text, o->name.length);
+    name[o->name.length] = '\0';
+    if ((found = hash_set_find(&renderer->options, name)) >= 0 &&
+        !values[found]) {
+      values[found] = list_leaf_value(&renderer->leaves[found], o);
+    }
+  }
+  json_object_object_foreach(map, key, val) {
+    long child = renderer->children[position++];
+    struct json_object *check = NULL;
+    if (child >= 0) {
+      check = values[child];
+    } else {
+      error err_rec = RE_OK;
+      check = build_recursive(val, path, &err_rec, 0);
+    }
+    if (check) {
+      json_object_object_add(entry, key, check);
+    }
+  }
+  return entry;
+}
+
 struct json_object *uci_get_list(struct json_object *yang, struct UciPath *path,
                                  error *err) {
+  struct ListRenderer renderer = INIT_LIST_RENDERER();
   struct json_object *array = NULL;
+  struct UciMap package = INIT_UCI_MAP();
+  const struct UciMapSection **sections = NULL;
+  const struct UciMapSection *named = NULL;
   int list_length;
   int single_item = path->where;
 
@@ -17,7 +179,9 @@ struct json_object *uci_get_list(struct json_object *yang, struct UciPath *path,
     *err = YANG_SCHEMA_ERROR;
     return NULL;
   }
-  if (strlen(path->section_type) == 0 || strlen(path->section) != 0) {
+  // only a single entry is addressed by its section name
+  if (strlen(path->section_type) == 0 ||
+      (!single_item && strlen(path->section) != 0)) {
     *err = YANG_SCHEMA_ERROR;
     return NULL;
   }
@@ -25,10 +189,27 @@ struct json_object *uci_get_list(struct json_object *yang, struct UciPath *path,
   struct json_object *map = NULL;
   json_object_object_get_ex(yang, YANG_MAP, &map);
 
-  if ((list_length = uci_list_length(path)) < 1) {
-    *err = RE_OK;
+  if (datastore_backend()->sections(path->package, &package)) {
+    *err = INTERNAL;
     return NULL;
   }
+  // the package is indexed once and each entry section is walked once
+  sections = uci_map_sections_of_type(&package, path->section_type);
+  if ((list_length = vector_size(sections)) < 1) {
+    *err = RE_OK;
+    goto done;
+  }
+  if (single_item && strlen(path->section) != 0) {
+    named = uci_map_section(&package, path->section);
+    if (!named || !uci_slice_is(named->type, path->section_type)) {
+      *err = RE_OK;
+      goto done;
+    }
+  }
+  if (list_renderer_init(map, &renderer)) {
+    *err = INTERNAL;
+    goto done;
+  }
 
   array = json_object_new_array();
   for (int index = 0; index < list_length; index++) {
@@ -36,15 +217,11 @@ struct json_object *uci_get_list(struct json_object *yang, struct UciPath *path,
       path->index = index;
       path->where = 1;
     }
-    struct json_object *top_level = json_object_new_object();
-    json_object_object_foreach(map, key, val) {
-      error err_rec = RE_OK;
-      struct json_object *check = build_recursive(val, path, &err_rec, 0);
-      if (check) {
-        json_object_object_add(top_level, key, check);
-      }
-    }
-    json_object_array_add(array, top_level);
+    const struct UciMapSection *section =
+        named ? named
+              : path->index < list_length ? sections[path->index] : NULL;
+    json_object_array_add(
+        array, list_render_entry(&renderer, map, section, path));
     if (single_item) {
       break;
     }
@@ -54,8 +231,13 @@ struct json_object *uci_get_list(struct json_object *yang, struct UciPath *path,
   path->index = 0;
   path->where = 0;
   if (json_object_array_length(array) == 0) {
-    return NULL;
+    json_object_put(array);
+    array = NULL;
   }
+done:
+  list_renderer_free(&renderer);
+  vector_free(sections);
+  uci_map_free(&package);
   return array;
 }
 
@@ -67,7 +249,7 @@ struct json_object *uci_get_leaf(struct json_object *yang, struct UciPath *path,
   struct json_object *type = NULL;
 
   uci_combine_to_path(path, path_string, sizeof(path_string));
-  if (uci_read_option(path_string, buf, sizeof(buf))) {
+  if (datastore_backend()->read_option(path_string, buf, sizeof(buf))) {
     *err = UCI_READ_FAILED;
     goto done;
   }
@@ -101,7 +283,7 @@ struct json_object *uci_get_leaf_list(struct json_object *yang,
   struct json_object *type = NULL;
 
   uci_combine_to_path(path, path_string, sizeof(path_string));
-  if (!(items = uci_read_list(path_string))) {
+  if (!(items = datastore_backend()->read_list(path_string))) {
     *err = UCI_READ_FAILED;
     goto done;
   }
@@ -128,4 +310,82 @@ struct json_object *uci_get_leaf_list(struct json_object *yang,
   *err = RE_OK;
 done:
   return output;
+}
+
+/**
+ * @brief encode the option values of the named leaves of a section as tuple
+ * @param yang the YANG list node
+ * @param names the JSON array of leaf names
+ * @param section the section of the list entry
+ * @param tuple set to the encoded tuple
+ * @return KEY_NOT_PRESENT if an option is missing, RE_OK if encoded
+ */
+static error section_tuple(struct json_object *yang, struct json_object *names,
+                           const struct UciMapSection *section, char **tuple) {
+  size_t count = json_object_array_length(names);
+  const char *values[count ? count : 1];
+  for (size_t i = 0; i < count; i++) {
+    const char *option = NULL;
+    struct json_object *leaf = json_get_object_from_map(
+        yang, json_object_get_string(json_object_array_get_idx(names, i)));
+    if (!leaf || !(option = json_get_string(leaf, YANG_UCI_OPTION))) {
+      return LEAF_NO_OPTION;
+    }
+    if (!(values[i] = uci_map_string(section, option))) {
+      return KEY_NOT_PRESENT;
+    }
+  }
+  if (!(*tuple = tuple_encode(values, count))) {
+    return INTERNAL;
+  }
+  return RE_OK;
+}
+
+/**
+ * @brief index the key and unique tuples of all entries of a list
+ * The package is indexed once and only the key and unique options are read.
+ * @param yang the YANG list node
+ * @param path the path of the list
+ * @param index the index the tuples are added to
+ * @return error in case of error else RE_OK
+ */
+error uci_get_list_index(struct json_object *yang, struct UciPath *path,
+                         struct ListIndex *index) {
+  struct json_object *names[2] = {json_get_array(yang, YANG_KEYS),
+                                  json_get_array(yang, YANG_UNIQUE)};
+  struct HashSet *sets[2] = {&index->keys, &index->unique};
+  struct UciMap package = INIT_UCI_MAP();
+  const struct UciMapSection **sections = NULL;
+  error err = RE_OK;
+
+  if (!names[0] && !names[1]) {
+    return RE_OK;
+  }
+  if (datastore_backend()->sections(path->package, &package)) {
+    return INTERNAL;
+  }
+  sections = uci_map_sections_of_type(&package, path->section_type);
+  for (size_t i = 0; i < vector_size(sections) && err == RE_OK; i++) {
+    for (int set = 0; set < 2; set++) {
+      char *tuple = NULL;
+      error tuple_err;
+      if (!names[set]) {
+        continue;
+      }
+      tuple_err = section_tuple(yang, names[set], sections[i], &tuple);
+      if (tuple_err == KEY_NOT_PRESENT) {
+        // an incomplete entry cannot collide with a new one
+        continue;
+      } else if (tuple_err != RE_OK) {
+        err = tuple_err;
+        break;
+      }
+      if (hash_set_add(sets[set], tuple) < 0) {
+        err = INTERNAL;
+      }
+    }
+  }
+  vector_free(sections);
+  uci_map_free(&package);
+  return err;
 }
\ No newline at end of file
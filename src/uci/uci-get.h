@@ -3,6 +3,7 @@
 
 #include "cgi.h"
 #include "error.h"
+#include "restconf-json.h"
 #include "uci/methods.h"
 
 struct json_object *uci_get_list(struct json_object *yang, struct UciPath *path,
@@ -11,5 +12,7 @@ struct json_object *uci_get_leaf(struct json_object *yang, struct UciPath *path,
                                  error *err);
 struct json_object *uci_get_leaf_list(struct json_object *yang,
                                       struct UciPath *path, error *err);
+error uci_get_list_index(struct json_object *yang, struct UciPath *path,
+                         struct ListIndex *index);
 
 #endif  // RESTCONF_UCI_GET_H
@@ -0,0 +1,764 @@
+#include "uci/uci-map.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "arena.h"
+#include "uci/methods.h"
+#include "util.h"
+#include "vector.h"
+
+// a configuration line has at most a keyword, a name and a value
+#define UCI_MAP_MAX_WORDS 3
+#define UCI_DELTA_COMMANDS "-@+|~^"
+
+static int is_blank(char c) { return c == ' ' || c == '\t'; }
+
+/**
+ * @brief scan a word, adjacent quoted and unquoted parts are joined
+ * Single quotes keep their content as is, backslashes escape the next
+ * character elsewhere. Quoted parts may span lines.
+ * @param p the start of the word
+ * @param end the end of the data
+ * @param out the buffer the unescaped word is written to or NULL
+ * @param length set to the length of the unescaped word
+ * @param plain set to 1 if the word is one part without escapes
+ * @return the end of the word or NULL if it is malformed
+ */
+static const char *scan_word(const char *p, const char *end, char *out,
+                             size_t *length, int *plain) {
+  size_t n = 0;
+  int parts = 0;
+  while (p < end && !is_blank(*p) && *p != '\n') {
+    char quote = 0;
+    if (*p == '\'' || *p == '"') {
+      quote = *p++;
+    }
+    parts++;
+    while (p < end && (quote ? *p != quote
+                             : !is_blank(*p) && *p != '\n' && *p != '\'' &&
+                                   *p != '"')) {
+      if (*p == '\\' && quote != '\'') {
+        // a line continued by a backslash is left to libuci
+        if (++p == end || *p == '\n') {
+          return NULL;
+        }
+        parts++;
+      }
+      if (out) {
+        out[n] = *p;
+      }
+      n++;
+      p++;
+    }
+    if (quote && p++ == end) {
+      return NULL;
+    }
+  }
+  *length = n;
+  *plain = parts == 1;
+  return p;
+}
+
+/**
+ * @brief read the words of the line at the cursor
+ * A word that is one part without escapes points into the data, any other
+ * one is unescaped into the request arena.
+ * @param cursor the position in the data, set to the start of the next line
+ * @param end the end of the data
+ * @param words set to the words of the line
+ * @return the number of words or -1 if the line is malformed
+ */
+static int read_line(const char **cursor, const char *end,
+                     struct UciSlice *words) {
+  const char *p = *cursor;
+  int count = 0;
+
+  while (1) {
+    const char *start = NULL;
+    size_t length = 0;
+    int plain = 0;
+    while (p < end && is_blank(*p)) {
+      p++;
+    }
+    if (p == end || *p == '\n' || *p == '#') {
+      break;
+    }
+    if (count == UCI_MAP_MAX_WORDS) {
+      return -1;
+    }
+    start = p;
+    if (!(p = scan_word(start, end, NULL, &length, &plain))) {
+      return -1;
+    }
+    if (plain) {
+      words[count].text = start + (*start == '\'' || *start == '"');
+    } else {
+      char *copy = arena_alloc(request_arena(), length + 1);
+      if (!copy) {
+        return -1;
+      }
+      scan_word(start, end, copy, &length, &plain);
+      words[count].text = copy;
+    }
+    words[count++].length = length;
+  }
+  while (p < end && *p != '\n') {
+    p++;
+  }
+  *cursor = p < end ? p + 1 : p;
+  return count;
+}
+
+/**
+ * @brief compare a slice to a string
+ * @param slice the slice
+ * @param name the string
+ * @return 1 if they are equal else 0
+ */
+int uci_slice_is(struct UciSlice slice, const char *name) {
+  return strlen(name) == slice.length &&
+         memcmp(slice.text, name, slice.length) == 0;
+}
+
+static int slice_equal(struct UciSlice a, struct UciSlice b) {
+  return a.length == b.length && memcmp(a.text, b.text, a.length) == 0;
+}
+
+/**
+ * @brief check a section or option name the way libuci does
+ * @param name the name
+ * @return 1 if it is valid else 0
+ */
+static int valid_name(struct UciSlice name) {
+  if (name.length == 0) {
+    return 0;
+  }
+  for (size_t i = 0; i < name.length; i++) {
+    if (!isalnum((unsigned char)name.text[i]) && name.text[i] != '_') {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/**
+ * @brief copy a slice into a terminated string in the request arena
+ * @param slice the slice
+ * @return the string or NULL on error
+ */
+char *uci_slice_dup(struct UciSlice slice) {
+  return strn_dup(slice.text, slice.length);
+}
+
+static long find_section(const struct UciMap *map, struct UciSlice name) {
+  for (size_t i = 0; i < vector_size(map->sections); i++) {
+    if (map->sections[i].name.text &&
+        slice_equal(map->sections[i].name, name)) {
+      return (long)i;
+    }
+  }
+  return -1;
+}
+
+static long find_option(const struct UciMapSection *section,
+                        struct UciSlice name) {
+  for (size_t i = 0; i < vector_size(section->options); i++) {
+    if (slice_equal(section->options[i].name, name)) {
+      return (long)i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief look up a named section
+ * @param map the package index
+ * @param name the name of the section
+ * @return the section or NULL if it does not exist
+ */
+struct UciMapSection *uci_map_section(struct UciMap *map, const char *name) {
+  struct UciSlice slice = {name, strlen(name)};
+  long index = find_section(map, slice);
+  return index < 0 ? NULL : &map->sections[index];
+}
+
+/**
+ * @brief look up an option of a section
+ * @param section the section
+ * @param name the name of the option
+ * @return the option or NULL if it is not set
+ */
+struct UciMapOption *uci_map_option(const struct UciMapSection *section,
+                                    const char *name) {
+  struct UciSlice slice = {name, strlen(name)};
+  long index = find_option(section, slice);
+  return index < 0 ? NULL : &section->options[index];
+}
+
+/**
+ * @brief read a string option of a section
+ * @param section the section
+ * @param option the name of the option
+ * @return the value in the request arena or NULL if it is no string option
+ */
+const char *uci_map_string(const struct UciMapSection *section,
+                           const char *option) {
+  struct UciMapOption *o = uci_map_option(section, option);
+  return o && !o->list ? uci_slice_dup(o->values[0]) : NULL;
+}
+
+/**
+ * @brief collect the sections of a type
+ * @param map the package index
+ * @param type the section type
+ * @return vector of the sections in the order of the package
+ */
+const struct UciMapSection **uci_map_sections_of_type(
+    const struct UciMap *map, const char *type) {
+  const struct UciMapSection **sections = NULL;
+  for (size_t i = 0; i < vector_size(map->sections); i++) {
+    if (uci_slice_is(map->sections[i].type, type)) {
+      vector_push_back(sections, &map->sections[i]);
+    }
+  }
+  return sections;
+}
+
+/**
+ * @brief split a UCI path into package, section and option
+ * @param path the path, an anonymous section is written as @type[index]
+ * @param parts set to the parts of the path
+ * @return 0 if success else 1 if it is malformed
+ */
+int uci_map_parse_path(const char *path, struct UciMapPath *parts) {
+  const char *dot = strchr(path, '.');
+  const char *section = NULL;
+
+  memset(parts, 0, sizeof(*parts));
+  parts->package.text = path;
+  parts->package.length = dot ? (size_t)(dot - path) : strlen(path);
+  if (!dot) {
+    return !valid_name(parts->package);
+  }
+  section = dot + 1;
+  if (*section == '@') {
+    const char *open = strchr(section, '[');
+    char *end = NULL;
+    if (!open) {
+      return 1;
+    }
+    parts->type.text = section + 1;
+    parts->type.length = (size_t)(open - section - 1);
+    parts->index = strtol(open + 1, &end, 10);
+    if (end == open + 1 || *end != ']') {
+      return 1;
+    }
+    dot = end[1] == '.' ? end + 1 : NULL;
+    if (!dot && end[1]) {
+      return 1;
+    }
+  } else {
+    dot = strchr(section, '.');
+    parts->section.text = section;
+    parts->section.length = dot ? (size_t)(dot - section) : strlen(section);
+  }
+  if (dot) {
+    parts->option.text = dot + 1;
+    parts->option.length = strlen(dot + 1);
+  }
+  return !valid_name(parts->package) ||
+         (parts->section.text && !valid_name(parts->section)) ||
+         (parts->type.text && parts->type.length == 0) ||
+         (parts->option.text && !valid_name(parts->option));
+}
+
+/**
+ * @brief find the section a path points at
+ * A negative index counts from the last section of the type.
+ * @param map the package index
+ * @param parts the parsed path
+ * @return the position of the section in the package or -1
+ */
+long uci_map_find(const struct UciMap *map, const struct UciMapPath *parts) {
+  long count = 0;
+  long index = parts->index;
+
+  if (parts->section.text) {
+    return find_section(map, parts->section);
+  } else if (!parts->type.text) {
+    return -1;
+  }
+  if (index < 0) {
+    for (size_t i = 0; i < vector_size(map->sections); i++) {
+      count += slice_equal(map->sections[i].type, parts->type);
+    }
+    index += count;
+  }
+  for (size_t i = 0; index >= 0 && i < vector_size(map->sections); i++) {
+    if (slice_equal(map->sections[i].type, parts->type) && index-- == 0) {
+      return (long)i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief look up the section and option a path points at
+ * @param map the package index
+ * @param parts the parsed path
+ * @param section set to the section or NULL
+ * @param option set to the option or NULL
+ * @return 1 if everything the path names exists else 0
+ */
+int uci_map_lookup(const struct UciMap *map, const struct UciMapPath *parts,
+                   const struct UciMapSection **section,
+                   const struct UciMapOption **option) {
+  long index = uci_map_find(map, parts);
+
+  *section = index < 0 ? NULL : &map->sections[index];
+  *option = NULL;
+  if (!*section) {
+    return 0;
+  } else if (!parts->option.text) {
+    return 1;
+  }
+  index = find_option(*section, parts->option);
+  *option = index < 0 ? NULL : &(*section)->options[index];
+  return *option != NULL;
+}
+
+/**
+ * @brief set an option or add a value to a list
+ * A string option that is added to becomes a list holding its value.
+ * @param section the section of the option
+ * @param name the name of the option
+ * @param value the value
+ * @param list 1 to add the value to a list else 0
+ * @return 0 if success else 1
+ */
+static int set_option(struct UciMapSection *section, struct UciSlice name,
+                      struct UciSlice value, int list) {
+  struct UciMapOption *option = NULL;
+  long index = find_option(section, name);
+
+  if (!valid_name(name)) {
+    return 1;
+  }
+  if (index < 0) {
+    struct UciMapOption added = {name, list, NULL};
+    vector_push_back(section->options, added);
+    index = (long)vector_size(section->options) - 1;
+  }
+  option = &section->options[index];
+  if (!list) {
+    vector_set_size(option->values, 0);
+  }
+  option->list = list;
+  vector_push_back(option->values, value);
+  return 0;
+}
+
+static void free_options(struct UciMapSection *section) {
+  for (size_t i = 0; i < vector_size(section->options); i++) {
+    vector_free(section->options[i].values);
+  }
+  vector_free(section->options);
+}
+
+static unsigned int djb_hash(unsigned int hash, struct UciSlice slice) {
+  for (size_t i = 0; i < slice.length; i++) {
+    hash = ((hash << 5) + hash) + slice.text[i];
+  }
+  return hash & 0x7FFFFFFF;
+}
+
+/**
+ * @brief name an anonymous section once it is read, as libuci does
+ * The name is made of the number of sections read so far and a hash of the
+ * type and the string options. Saved deltas refer to the section by it.
+ * @param map the package index
+ * @param section the section that has been read
+ * @return 0 if success else 1
+ */
+static int name_anonymous(struct UciMap *map, struct UciMapSection *section) {
+  unsigned int hash = djb_hash(5381, section->type);
+  char name[16];
+
+  if (!section->anonymous) {
+    return 0;
+  }
+  for (size_t i = 0; i < vector_size(section->options); i++) {
+    struct UciMapOption *option = &section->options[i];
+    hash = djb_hash(hash, option->name);
+    if (!option->list) {
+      hash = djb_hash(hash, option->values[0]);
+    }
+  }
+  snprintf(name, sizeof(name), "cfg%02x%04x", map->count, hash % (1 << 16));
+  section->name.length = strlen(name);
+  return !(section->name.text = strn_dup(name, section->name.length));
+}
+
+/**
+ * @brief index the sections and options of the mapped configuration file
+ * @param map the package index
+ * @return 0 if success else 1 if the file is not read the way libuci would
+ */
+static int parse_config(struct UciMap *map) {
+  struct UciSlice words[UCI_MAP_MAX_WORDS];
+  const char *cursor = map->data;
+  const char *end = map->data + map->size;
+  struct UciMapSection *section = NULL;
+
+  while (cursor < end) {
+    int count = read_line(&cursor, end, words);
+    if (count < 0) {
+      return 1;
+    } else if (count == 0) {
+      continue;
+    }
+    if (uci_slice_is(words[0], "package")) {
+      if (count != 2 || section) {
+        return 1;
+      }
+    } else if (uci_slice_is(words[0], "config")) {
+      struct UciMapSection added = {{NULL, 0}, words[1], 1, NULL};
+      if (count < 2 || (section && name_anonymous(map, section))) {
+        return 1;
+      }
+      if (count == 3 && words[2].length > 0) {
+        if (!valid_name(words[2]) || find_section(map, words[2]) >= 0) {
+          return 1;
+        }
+        added.name = words[2];
+        added.anonymous = 0;
+      }
+      vector_push_back(map->sections, added);
+      section = &map->sections[vector_size(map->sections) - 1];
+      map->count++;
+    } else if (uci_slice_is(words[0], "option") ||
+               uci_slice_is(words[0], "list")) {
+      if (count != 3 || !section ||
+          set_option(section, words[1], words[2],
+                     uci_slice_is(words[0], "list"))) {
+        return 1;
+      }
+    } else {
+      return 1;
+    }
+  }
+  return section && name_anonymous(map, section);
+}
+
+/**
+ * @brief apply one change in the format of a saved delta
+ * A delta that refers to a section that is not in the index is not skipped
+ * like libuci does, the index is given up instead. The names and values
+ * point into the word.
+ * @param map the package index
+ * @param command the command of the delta or 0 to set a value
+ * @param word the package, section, option and value of the delta
+ * @param package the name of the package
+ * @return 0 if success else 1
+ */
+int uci_map_apply(struct UciMap *map, char command, struct UciSlice word,
+                  const char *package) {
+  struct UciSlice parts[3] = {{NULL, 0}, {NULL, 0}, {NULL, 0}};
+  struct UciSlice value = {NULL, 0};
+  const char *equals = memchr(word.text, '=', word.length);
+  const char *path_end = equals ? equals : word.text + word.length;
+  const char *p = word.text;
+  struct UciMapSection *section = NULL;
+  long index;
+  int count = 0;
+
+  if (equals) {
+    value.text = equals + 1;
+    value.length = word.text + word.length - value.text;
+  }
+  while (1) {
+    const char *dot = memchr(p, '.', path_end - p);
+    if (count == 3) {
+      return 1;
+    }
+    parts[count].text = p;
+    parts[count++].length = (dot ? dot : path_end) - p;
+    if (!dot) {
+      break;
+    }
+    p = dot + 1;
+  }
+  if (!uci_slice_is(parts[0], package)) {
+    return 0;
+  }
+  if (count < 2 || (index = find_section(map, parts[1])) < 0) {
+    if (count == 2 && equals && (command == 0 || command == '+') &&
+        valid_name(parts[1])) {
+      // a section that is added
+      struct UciMapSection added = {parts[1], value, command == '+', NULL};
+      vector_push_back(map->sections, added);
+      return 0;
+    }
+    return 1;
+  }
+  section = &map->sections[index];
+  switch (command) {
+    case 0:
+    case '+':
+      if (!equals) {
+        return 1;
+      } else if (count == 2) {
+        section->type = value;
+        section->anonymous |= command == '+';
+        return 0;
+      }
+      return set_option(section, parts[2], value, 0);
+    case '|':
+      return count != 3 || !equals || set_option(section, parts[2], value, 1);
+    case '~':
+      if (count != 3 || !equals) {
+        return 1;
+      } else if ((index = find_option(section, parts[2])) >= 0 &&
+                 section->options[index].list) {
+        struct UciSlice *values = section->options[index].values;
+        for (size_t i = vector_size(values); i-- > 0;) {
+          if (slice_equal(values[i], value)) {
+            vector_erase(values, i);
+          }
+        }
+      }
+      return 0;
+    case '-':
+      if (count == 2) {
+        free_options(section);
+        vector_erase(map->sections, (size_t)index);
+      } else if ((index = find_option(section, parts[2])) >= 0) {
+        vector_free(section->options[index].values);
+        vector_erase(section->options, (size_t)index);
+      }
+      return 0;
+    case '@':
+      if (!equals || !valid_name(value)) {
+        return 1;
+      } else if (count == 2) {
+        if (find_section(map, value) >= 0) {
+          return 1;
+        }
+        section->name = value;
+        section->anonymous = 0;
+        return 0;
+      } else if ((index = find_option(section, parts[2])) < 0 ||
+                 find_option(section, value) >= 0) {
+        return 1;
+      }
+      section->options[index].name = value;
+      return 0;
+    case '^': {
+      struct UciMapSection moved = *section;
+      char position[16];
+      size_t to;
+      if (count != 2 || !equals || value.length >= sizeof(position)) {
+        return 1;
+      }
+      memcpy(position, value.text, value.length);
+      position[value.length] = '\0';
+      to = (size_t)strtoul(position, NULL, 10);
+      vector_erase(map->sections, (size_t)index);
+      vector_push_back(map->sections, moved);
+      if (to < vector_size(map->sections)) {
+        memmove(&map->sections[to + 1], &map->sections[to],
+                (vector_size(map->sections) - 1 - to) * sizeof(moved));
+        map->sections[to] = moved;
+      }
+      return 0;
+    }
+    default:
+      return 1;
+  }
+}
+
+/**
+ * @brief apply the deltas of a package saved in a directory
+ * @param map the package index
+ * @param savedir the directory the deltas are saved in
+ * @param package the name of the package
+ * @return 0 if success else 1
+ */
+static int apply_deltas(struct UciMap *map, const char *savedir,
+                        const char *package) {
+  struct UciSlice words[UCI_MAP_MAX_WORDS];
+  char path[512];
+  struct stat st;
+  char *data = NULL;
+  const char *cursor = NULL;
+  ssize_t length = 0;
+  int fd;
+
+  snprintf(path, sizeof(path), "%s/%s", savedir, package);
+  if ((fd = open(path, O_RDONLY)) < 0) {
+    return errno != ENOENT;
+  }
+  // the values of the deltas stay in the request arena
+  if (fstat(fd, &st) ||
+      !(data = arena_alloc(request_arena(), (size_t)st.st_size + 1)) ||
+      (length = read(fd, data, (size_t)st.st_size)) != st.st_size) {
+    close(fd);
+    return 1;
+  }
+  close(fd);
+  cursor = data;
+  while (cursor < data + length) {
+    char command =
+        *cursor && strchr(UCI_DELTA_COMMANDS, *cursor) ? *cursor : 0;
+    int count = read_line(&cursor, data + length, words);
+    if (count == 0) {
+      continue;
+    } else if (count != 1 ||
+               uci_map_apply(map, command,
+                           command ? (struct UciSlice){words[0].text + 1,
+                                                       words[0].length - 1}
+                                   : words[0],
+                           package)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief index a package of the selected datastore without loading it
+ * The configuration file is mapped and the deltas of the running datastore
+ * and, for the candidate datastore, of its own directory are applied, followed
+ * by the uncommitted changes of this request. A file
+ * that libuci would read differently is not indexed, it is left to libuci.
+ * @param map the package index
+ * @param package the name of the package
+ * @return 0 if success else 1
+ */
+int uci_map_open(struct UciMap *map, const char *package) {
+  struct UciSlice name = {package, strlen(package)};
+  char path[512];
+  struct stat st;
+  int fd;
+
+  *map = (struct UciMap)INIT_UCI_MAP();
+  if (!valid_name(name)) {
+    return 1;
+  }
+  snprintf(path, sizeof(path), "%s/%s", RESTCONF_UCI_CONFDIR, package);
+  if ((fd = open(path, O_RDONLY)) < 0) {
+    return 1;
+  }
+  if (fstat(fd, &st) || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return 1;
+  }
+  if (st.st_size > 0) {
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return 1;
+    }
+    map->data = data;
+    map->size = (size_t)st.st_size;
+  }
+  close(fd);
+  if (parse_config(map) || apply_deltas(map, RESTCONF_UCI_SAVEDIR, package) ||
+      (uci_get_datastore() == DATASTORE_CANDIDATE &&
+       apply_deltas(map, RESTCONF_CANDIDATE_SAVEDIR, package)) ||
+      apply_deltas(map, uci_request_savedir(), package)) {
+    uci_map_free(map);
+    return 1;
+  }
+  return 0;
+}
+
+static struct UciSlice slice_of(const char *text) {
+  struct UciSlice slice = {strn_dup(text, strlen(text)), strlen(text)};
+  return slice;
+}
+
+/**
+ * @brief index a package that libuci has loaded
+ * The names and values are copied into the request arena, so the context
+ * of the package can be freed.
+ * @param map the package index
+ * @param package the package
+ */
+void uci_map_from_package(struct UciMap *map, struct uci_package *package) {
+  struct uci_element *s = NULL;
+  struct uci_element *o = NULL;
+  struct uci_element *e = NULL;
+
+  *map = (struct UciMap)INIT_UCI_MAP();
+  uci_foreach_element(&package->sections, s) {
+    struct uci_section *section = uci_to_section(s);
+    struct UciMapSection added = {slice_of(s->name), slice_of(section->type),
+                                  section->anonymous, NULL};
+    uci_foreach_element(&section->options, o) {
+      struct uci_option *option = uci_to_option(o);
+      struct UciMapOption item = {slice_of(o->name),
+                                  option->type == UCI_TYPE_LIST, NULL};
+      if (option->type == UCI_TYPE_LIST) {
+        uci_foreach_element(&option->v.list, e) {
+          vector_push_back(item.values, slice_of(e->name));
+        }
+      } else {
+        vector_push_back(item.values, slice_of(option->v.string));
+      }
+      vector_push_back(added.options, item);
+    }
+    vector_push_back(map->sections, added);
+  }
+  map->count = vector_size(map->sections);
+}
+
+/**
+ * @brief copy the sections and options of a package index
+ * The names and values are shared with the copied index.
+ * @param map the copy
+ * @param from the copied index
+ */
+void uci_map_copy(struct UciMap *map, const struct UciMap *from) {
+  *map = (struct UciMap)INIT_UCI_MAP();
+  map->count = from->count;
+  vector_reserve(map->sections, vector_size(from->sections));
+  for (size_t i = 0; i < vector_size(from->sections); i++) {
+    const struct UciMapSection *section = &from->sections[i];
+    struct UciMapSection copy = *section;
+    copy.options = NULL;
+    vector_reserve(copy.options, vector_size(section->options));
+    for (size_t j = 0; j < vector_size(section->options); j++) {
+      const struct UciMapOption *option = &section->options[j];
+      struct UciMapOption item = *option;
+      item.values = NULL;
+      vector_reserve(item.values, vector_size(option->values));
+      for (size_t k = 0; k < vector_size(option->values); k++) {
+        vector_push_back(item.values, option->values[k]);
+      }
+      vector_push_back(copy.options, item);
+    }
+    vector_push_back(map->sections, copy);
+  }
+}
+
+/**
+ * @brief free a package index and unmap its file
+ * @param map the package index
+ */
+void uci_map_free(struct UciMap *map) {
+  for (size_t i = 0; i < vector_size(map->sections); i++) {
+    free_options(&map->sections[i]);
+  }
+  vector_free(map->sections);
+  if (map->data) {
+    munmap(map->data, map->size);
+  }
+  *map = (struct UciMap)INIT_UCI_MAP();
+}
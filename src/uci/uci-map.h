@@ -0,0 +1,96 @@
+#ifndef RESTCONF_UCI_MAP_H
+#define RESTCONF_UCI_MAP_H
+
+#include <stddef.h>
+#include <uci.h>
+
+#ifndef UCI_CONFDIR
+#define UCI_CONFDIR "/etc/config"
+#endif
+#ifndef UCI_SAVEDIR
+#define UCI_SAVEDIR "/tmp/.uci"
+#endif
+// the directories packages are indexed from, the ones of libuci by default
+#ifndef RESTCONF_UCI_CONFDIR
+#define RESTCONF_UCI_CONFDIR UCI_CONFDIR
+#endif
+#ifndef RESTCONF_UCI_SAVEDIR
+#define RESTCONF_UCI_SAVEDIR UCI_SAVEDIR
+#endif
+
+/**
+ * A name or value of a package index, it is not terminated
+ * It points into the mapped file unless it had to be unescaped.
+ */
+struct UciSlice {
+  const char *text;
+  size_t length;
+};
+
+struct UciMapOption {
+  struct UciSlice name;
+  int list;
+  struct UciSlice *values;
+};
+
+/**
+ * A section of a package index, anonymous sections carry the name libuci
+ * generates for them so the saved deltas can refer to them
+ */
+struct UciMapSection {
+  struct UciSlice name;
+  struct UciSlice type;
+  int anonymous;
+  struct UciMapOption *options;
+};
+
+/**
+ * A read-only index of the sections and options of a package
+ * The configuration file is mapped and tokenised in place and the deltas of
+ * the save directories are applied on top. Only values that are quoted in
+ * several parts or escaped are copied into the request arena.
+ */
+struct UciMap {
+  char *data;
+  size_t size;
+  unsigned int count;
+  struct UciMapSection *sections;
+};
+
+#define INIT_UCI_MAP() \
+  { NULL, 0, 0, NULL }
+
+/**
+ * A UCI path split into its parts, the section is either named or the
+ * anonymous section at an index of a type as in package.@type[index]
+ */
+struct UciMapPath {
+  struct UciSlice package;
+  struct UciSlice section;
+  struct UciSlice type;
+  struct UciSlice option;
+  long index;
+};
+
+int uci_map_open(struct UciMap *map, const char *package);
+void uci_map_from_package(struct UciMap *map, struct uci_package *package);
+void uci_map_copy(struct UciMap *map, const struct UciMap *from);
+void uci_map_free(struct UciMap *map);
+int uci_map_apply(struct UciMap *map, char command, struct UciSlice word,
+                  const char *package);
+int uci_slice_is(struct UciSlice slice, const char *name);
+char *uci_slice_dup(struct UciSlice slice);
+int uci_map_parse_path(const char *path, struct UciMapPath *parts);
+long uci_map_find(const struct UciMap *map, const struct UciMapPath *parts);
+int uci_map_lookup(const struct UciMap *map, const struct UciMapPath *parts,
+                   const struct UciMapSection **section,
+                   const struct UciMapOption **option);
+struct UciMapSection *uci_map_section(struct UciMap *map, const char *name);
+const struct UciMapSection **uci_map_sections_of_type(
+    const struct UciMap *map, const char *type);
+struct UciMapOption *uci_map_option(const struct UciMapSection *section,
+                                    const char *name);
+const char *uci_map_string(const struct UciMapSection *section,
+                           const char *option);
+
+#endif  // RESTCONF_UCI_MAP_H
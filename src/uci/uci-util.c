@@ -1,7 +1,16 @@
 #include "uci/uci-util.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <restconf.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "http.h"
+#include "intern.h"
 #include "restconf-json.h"
+#include "util.h"
 #include "vector.h"
 #include "yang-util.h"
 
@@ -61,7 +70,8 @@ int combine_to_anonymous_path(struct UciPath *path, int index, char *buffer,
  */
 int uci_combine_to_path(struct UciPath *path, char *buffer,
                         size_t buffer_size) {
-  if (path->where) {
+  // a list entry that has a section name is addressed by it
+  if (path->where && (!path->section || strlen(path->section) == 0)) {
     combine_to_anonymous_path(path, path->index, buffer, buffer_size);
   } else {
     combine_to_path(path, buffer, buffer_size);
@@ -69,6 +79,25 @@ int uci_combine_to_path(struct UciPath *path, char *buffer,
   return 0;
 }
 
+/**
+ * Interns a name of a path unless it is not set
+ * @param name the name
+ * @return 0 if success else 1
+ */
+static int intern_name(char **name) {
+  return *name && !(*name = intern(*name));
+}
+
+/**
+ * Interns the names of a path so paths can be compared by address
+ * @param path the path
+ * @return 0 if success else 1
+ */
+int uci_path_intern(struct UciPath *path) {
+  return intern_name(&path->package) || intern_name(&path->section) ||
+         intern_name(&path->section_type) || intern_name(&path->option);
+}
+
 int get_path_from_yang(struct json_object *jobj, struct UciPath *uci) {
   struct json_object *uci_value = NULL;
   char *uci_package = NULL;
@@ -181,26 +210,328 @@ int get_leaf_as_name(struct json_object *yang, struct json_object *json,
   return 0;
 }
 
-int uci_revert_all(char **package_list) {
+/**
+ * Derives the section name of a list entry from the values of its keys
+ * The name is the key-hash-name prefix followed by the 64 bit FNV-1a hash of
+ * the key tuple, so it does not change when other entries are removed.
+ * @param yang the YANG list node
+ * @param values the key values in the order of the key statement
+ * @return the section name or NULL if the list is not named by its keys
+ */
+char *uci_key_hash_name(struct json_object *yang, const char *const *values) {
+  const char *prefix = json_get_string(yang, YANG_UCI_KEY_HASH_NAME);
+  struct json_object *keys = json_get_array(yang, YANG_KEYS);
+  uint64_t hash = 14695981039346656037ull;
+  char name[128];
+
+  if (!prefix || !keys) {
+    return NULL;
+  }
+  for (size_t i = 0; i < json_object_array_length(keys); i++) {
+    // the terminator is hashed as well to separate the values
+    const char *value = values[i];
+    do {
+      hash ^= (unsigned char)*value;
+      hash *= 1099511628211ull;
+    } while (*value++);
+  }
+  snprintf(name, sizeof(name), "%s_%016" PRIx64, prefix, hash);
+  return str_dup(name);
+}
+
+/**
+ * Sets the section name of a list entry derived from the keys in its content
+ * The section is left unchanged if the list is not named by its keys or a
+ * key is missing, which is reported when the entry is verified.
+ * @param yang the YANG list node
+ * @param json the content of the entry
+ * @param uci the UCI path of the entry
+ * @return 0 if success else 1
+ */
+int get_key_hash_name(struct json_object *yang, struct json_object *json,
+                      struct UciPath *uci) {
+  struct json_object *keys = json_get_array(yang, YANG_KEYS);
+  char *name = NULL;
+
+  if (!keys || !json_get_string(yang, YANG_UCI_KEY_HASH_NAME)) {
+    return 0;
+  }
+  const char *values[json_object_array_length(keys) + 1];
+  for (size_t i = 0; i < json_object_array_length(keys); i++) {
+    struct json_object *value = NULL;
+    if (!json_object_object_get_ex(
+            json, json_object_get_string(json_object_array_get_idx(keys, i)),
+            &value) ||
+        json_object_get_type(value) == json_type_object ||
+        json_object_get_type(value) == json_type_array) {
+      return 0;
+    }
+    values[i] = json_object_get_string(value);
+  }
+  if (!(name = uci_key_hash_name(yang, values))) {
+    return 1;
+  }
+  uci->section = name;
+  return 0;
+}
+
+/**
+ * Opens a delta file and locks it like libuci locks it while saving
+ * A file that was claimed and removed while waiting for the lock is not
+ * written to, the path is opened again instead.
+ * @param path the delta file
+ * @param flags the flags passed to open
+ * @return the locked file descriptor or -1
+ */
+static int open_locked(const char *path, int flags) {
+  struct stat st;
+  int fd;
+  while ((fd = open(path, flags, 0600)) >= 0) {
+    if (flock(fd, LOCK_EX) || fstat(fd, &st)) {
+      close(fd);
+      return -1;
+    }
+    if (st.st_nlink > 0) {
+      return fd;
+    }
+    close(fd);
+  }
+  return -1;
+}
+
+/**
+ * Takes the delta file of a package out of a delta directory
+ * The file is locked and renamed to a name of this process, so changes
+ * appended by other requests either end up in the claimed file or in a new
+ * one. The lock is held until the claimed file is removed.
+ * @param savedir the delta directory
+ * @param package the package name
+ * @param claimed buffer that receives the path of the claimed file
+ * @param size the size of the buffer
+ * @return the locked file descriptor, -1 if there are no deltas or -2
+ */
+static int claim_deltas(const char *savedir, const char *package,
+                        char *claimed, size_t size) {
+  char path[512];
+  int fd;
+
+  snprintf(path, sizeof(path), "%s/%s", savedir, package);
+  if ((fd = open_locked(path, O_RDONLY)) < 0) {
+    return errno == ENOENT ? -1 : -2;
+  }
+  snprintf(claimed, size, "%s/.%s-%ld", savedir, package, (long)getpid());
+  if (rename(path, claimed)) {
+    close(fd);
+    return -2;
+  }
+  return fd;
+}
+
+/**
+ * Removes the delta files of packages from a delta directory
+ * @param savedir the delta directory
+ * @param package_list the vector of package names
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int drop_deltas(const char *savedir, char **package_list) {
+  char claimed[512];
   for (size_t i = 0; i < vector_size(package_list); i++) {
-    char *item = package_list[i];
-    if (uci_revert_package(item)) {
+    int failed;
+    int fd = claim_deltas(savedir, package_list[i], claimed, sizeof(claimed));
+    if (fd == -1) {
+      continue;
+    } else if (fd < 0) {
+      return 1;
+    }
+    failed = unlink(claimed) != 0;
+    close(fd);
+    if (failed) {
       return 1;
     }
   }
   return 0;
 }
 
-int uci_commit_all(char **package_list) {
+/**
+ * Appends the delta files of packages to the ones in another delta directory
+ * and removes them from their own
+ * Both files are locked like libuci locks them while saving.
+ * @param from the delta directory the deltas are moved from
+ * @param to the delta directory the deltas are moved to
+ * @param package_list the vector of package names
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int publish_deltas(const char *from, const char *to,
+                          char **package_list) {
+  char path[512];
+  char claimed[512];
+  char buffer[4096];
+  ssize_t length;
+
+  if (mkdir(to, 0700) && errno != EEXIST) {
+    return 1;
+  }
   for (size_t i = 0; i < vector_size(package_list); i++) {
-    char *item = package_list[i];
-    if (uci_commit_package(item)) {
+    int failed = 0;
+    int in_fd;
+    int out_fd;
+
+    in_fd = claim_deltas(from, package_list[i], claimed, sizeof(claimed));
+    if (in_fd == -1) {
+      continue;
+    } else if (in_fd < 0) {
+      return 1;
+    }
+    snprintf(path, sizeof(path), "%s/%s", to, package_list[i]);
+    if ((out_fd = open_locked(path, O_WRONLY | O_CREAT | O_APPEND)) < 0) {
+      close(in_fd);
+      return 1;
+    }
+    while ((length = read(in_fd, buffer, sizeof(buffer))) > 0) {
+      if (write(out_fd, buffer, (size_t)length) != length) {
+        failed = 1;
+        break;
+      }
+    }
+    failed = failed || length < 0;
+    flock(out_fd, LOCK_UN);
+    close(out_fd);
+    // removed before the lock is released, so waiting writers open it again
+    failed = failed || unlink(claimed);
+    close(in_fd);
+    if (failed) {
       return 1;
     }
   }
   return 0;
 }
 
+/**
+ * Drops the uncommitted changes this request made to the packages
+ * The changes of other requests are not touched.
+ * @param package_list the vector of package names to be reverted
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_revert_all(char **package_list) {
+  return drop_deltas(uci_request_savedir(), package_list);
+}
+
+/**
+ * Commits the saved deltas of all packages as one group commit
+ *
+ * Concurrent writers publish their deltas and then queue on the commit lock,
+ * announcing themselves with a shared lock on the queue file while they wait.
+ * If others are queued, the holder of the commit lock waits for the group
+ * commit window, then it commits every package once, including the deltas
+ * published by the queued writers, which then find nothing left to commit.
+ * @param package_list the vector of package names to be committed
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+static int group_commit(char **package_list) {
+  int retval = 0;
+  int queue_fd = open(RESTCONF_COMMIT_QUEUE, O_RDWR | O_CREAT, 0600);
+  int lock_fd = open(RESTCONF_COMMIT_LOCK, O_RDWR | O_CREAT, 0600);
+  if (queue_fd >= 0) {
+    flock(queue_fd, LOCK_SH);
+  }
+  if (lock_fd >= 0) {
+    flock(lock_fd, LOCK_EX);
+  }
+  if (queue_fd >= 0) {
+    flock(queue_fd, LOCK_UN);
+    // the exclusive lock is only granted if no other writer is queued
+    if (RESTCONF_COMMIT_WINDOW_US > 0 && lock_fd >= 0 &&
+        flock(queue_fd, LOCK_EX | LOCK_NB) != 0) {
+      usleep(RESTCONF_COMMIT_WINDOW_US);
+    }
+    close(queue_fd);
+  }
+  for (size_t i = 0; i < vector_size(package_list); i++) {
+    char *item = package_list[i];
+    if (uci_commit_package(item)) {
+      retval = 1;
+      break;
+    }
+  }
+  if (lock_fd >= 0) {
+    flock(lock_fd, LOCK_UN);
+    close(lock_fd);
+  }
+  return retval;
+}
+
+/**
+ * Commits the changes this request made to the packages of the selected
+ * datastore
+ * Changes to the candidate datastore are moved to its delta directory, where
+ * they stay until uci_commit_candidate is called.
+ * @param package_list the vector of package names to be committed
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_commit_all(char **package_list) {
+  if (uci_get_datastore() == DATASTORE_CANDIDATE) {
+    return publish_deltas(uci_request_savedir(), RESTCONF_CANDIDATE_SAVEDIR,
+                          package_list);
+  }
+  if (publish_deltas(uci_request_savedir(), UCI_SAVEDIR, package_list)) {
+    return 1;
+  }
+  return group_commit(package_list);
+}
+
+/**
+ * Lists the packages that have staged changes in the candidate datastore
+ * @return vector of package names in the request arena
+ */
+static char **candidate_packages() {
+  char **package_list = NULL;
+  struct dirent *entry = NULL;
+  DIR *dir = opendir(RESTCONF_CANDIDATE_SAVEDIR);
+  if (!dir) {
+    return NULL;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    char *name = NULL;
+    if (entry->d_name[0] == '.') {
+      continue;
+    }
+    if ((name = str_dup(entry->d_name))) {
+      vector_push_back(package_list, name);
+    }
+  }
+  closedir(dir);
+  return package_list;
+}
+
+/**
+ * Writes all staged changes of the candidate datastore to the running
+ * configuration
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_commit_candidate() {
+  int retval;
+  char **package_list = candidate_packages();
+
+  retval = publish_deltas(RESTCONF_CANDIDATE_SAVEDIR, UCI_SAVEDIR,
+                          package_list) ||
+           group_commit(package_list);
+  vector_free(package_list);
+  return retval;
+}
+
+/**
+ * Drops all staged changes of the candidate datastore
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int uci_discard_candidate() {
+  int retval;
+  char **package_list = candidate_packages();
+
+  retval = drop_deltas(RESTCONF_CANDIDATE_SAVEDIR, package_list);
+  vector_free(package_list);
+  return retval;
+}
+
 int uci_element_exists(struct UciPath *path) {
   char path_string[512];
   uci_combine_to_path(path, path_string, sizeof(path_string));
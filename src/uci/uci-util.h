@@ -3,15 +3,27 @@
 
 #include "methods.h"
 
+#define RESTCONF_COMMIT_LOCK "/var/lock/restconf-commit.lock"
+#define RESTCONF_COMMIT_QUEUE "/var/lock/restconf-commit.queue"
+#ifndef RESTCONF_COMMIT_WINDOW_US
+#define RESTCONF_COMMIT_WINDOW_US 5000
+#endif
+
 int combine_to_path(struct UciPath *path, char *buffer, size_t size);
 int combine_to_anonymous_path(struct UciPath *path, int index, char *buffer,
                               size_t size);
 int uci_combine_to_path(struct UciPath *path, char *buffer, size_t buffer_size);
+int uci_path_intern(struct UciPath *path);
 int get_path_from_yang(struct json_object *jobj, struct UciPath *uci);
 int get_leaf_as_name(struct json_object *yang, struct json_object *json,
                      struct UciPath *uci);
+char *uci_key_hash_name(struct json_object *yang, const char *const *values);
+int get_key_hash_name(struct json_object *yang, struct json_object *json,
+                      struct UciPath *uci);
 int uci_revert_all(char **package_list);
 int uci_commit_all(char **package_list);
+int uci_commit_candidate();
+int uci_discard_candidate();
 int uci_element_exists(struct UciPath *path);
 
 #endif  // RESTCONF_UCI_UTIL_
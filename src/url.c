@@ -4,52 +4,121 @@
 #include "vector.h"
 
 /**
- * @brief convert comma separated list into vector
- * @param list the comma separated list
- * @return the vector of seperated items
+ * @brief get the value of a hex digit
+ * @param c the hex digit
+ * @return the value
  */
-char **clist_to_vec(char *list) {
-  char **vec = NULL;
-  char *next;
-  char *curr = list;
-  while ((next = strchr(curr, ',')) != NULL) {
-    *next = '\0';
-    vector_push_back(vec, curr);
-    curr = next + 1;
+static char hex_value(char c) {
+  if (c >= 'a') {
+    return (char)(c - 'a' + 10);
+  } else if (c >= 'A') {
+    return (char)(c - 'A' + 10);
   }
-  vector_push_back(vec, curr);
-  return vec;
+  return (char)(c - '0');
 }
 
 /**
- * @brief Decodes a URL
- * Taken from https://stackoverflow.com/a/14530993
- * @param dst the output string
- * @param src the string to be decoded
+ * @brief split the keys of a segment and decode them in place
+ * The keys are separated before they are decoded, so an encoded comma is part
+ * of a key. An encoded NUL is rejected, it would end the key early.
+ * @param iter the first character after '='
+ * @param segment the segment the keys are stored in
+ * @return the first character after the keys or NULL if a key is malformed
  */
-void urldecode(char *dst, const char *src) {
-  char a, b;
-  while (*src) {
-    if ((*src == '%') && ((a = src[1]) && (b = src[2])) &&
-        (isxdigit(a) && isxdigit(b))) {
-      if (a >= 'a') a -= 'a' - 'A';
-      if (a >= 'A')
-        a -= ('A' - 10);
-      else
-        a -= '0';
-      if (b >= 'a') b -= 'a' - 'A';
-      if (b >= 'A')
-        b -= ('A' - 10);
-      else
-        b -= '0';
-      *dst++ = (char)16 * a + b;
-      src += 3;
-    } else if (*src == '+') {
-      *dst++ = ' ';
-      src++;
+static char *parse_keys(char *iter, struct PathSegment *segment) {
+  char *out = iter;
+  segment->keys = out;
+  segment->key_count = 1;
+  while (*iter && *iter != '/') {
+    if (*iter == ',') {
+      *out++ = '\0';
+      iter++;
+      segment->key_count++;
+    } else if (*iter == '%' && isxdigit((unsigned char)iter[1]) &&
+               isxdigit((unsigned char)iter[2])) {
+      if (!(*out++ = (char)(16 * hex_value(iter[1]) + hex_value(iter[2])))) {
+        return NULL;
+      }
+      iter += 3;
+    } else if (*iter == '+') {
+      *out++ = ' ';
+      iter++;
     } else {
-      *dst++ = *src++;
+      *out++ = *iter++;
     }
   }
-  *dst++ = '\0';
-}
\ No newline at end of file
+  if (*iter == '/') {
+    *iter++ = '\0';
+  }
+  // the decoded keys are never longer than the encoded ones
+  *out = '\0';
+  return iter;
+}
+
+/**
+ * @brief split a request path into its segments in a single pass
+ * The path is modified in place, nothing is copied. Empty segments are
+ * skipped.
+ * @param path the path, it has to outlive the segments
+ * @param segments the vector the segments are appended to, it may use inline
+ * storage
+ * @return 0 if success, 1 if a key is malformed
+ */
+int path_parse(char *path, struct PathSegment **segments) {
+  struct PathSegment *parsed = *segments;
+  char *iter = path;
+  int retval = 0;
+  while (*iter) {
+    struct PathSegment segment = {NULL, NULL, NULL, 0};
+    if (*iter == '/') {
+      iter++;
+      continue;
+    }
+    segment.name = iter;
+    while (*iter && *iter != '/' && *iter != '=') {
+      if (*iter == ':' && !segment.module) {
+        *iter = '\0';
+        segment.module = segment.name;
+        segment.name = iter + 1;
+      }
+      iter++;
+    }
+    if (*iter == '=') {
+      *iter++ = '\0';
+      if (!(iter = parse_keys(iter, &segment))) {
+        retval = 1;
+        break;
+      }
+    } else if (*iter == '/') {
+      *iter++ = '\0';
+    }
+    vector_push_back(parsed, segment);
+  }
+  *segments = parsed;
+  return retval;
+}
+
+/**
+ * @brief get the key following a key of a segment
+ * @param key the key, it must not be the last one
+ * @return the next key
+ */
+char *path_key_next(char *key) { return key + strlen(key) + 1; }
+
+/**
+ * @brief check the module and name of a segment
+ * @param segment the segment
+ * @param module the module name or NULL for an unqualified segment
+ * @param name the node name
+ * @return 1 if the segment names the node without keys else 0
+ */
+int path_segment_is(const struct PathSegment *segment, const char *module,
+                    const char *name) {
+  if (segment->keys || strcmp(segment->name, name) != 0) {
+    return 0;
+  }
+  if (!module || !segment->module) {
+    return module == segment->module;
+  }
+  return strcmp(segment->module, module) == 0;
+}
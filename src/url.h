@@ -1,5 +1,20 @@
 #ifndef RESTCONF_URL_H
 #define RESTCONF_URL_H
-char** clist_to_vec(char* list);
-void urldecode(char* dst, const char* src);
+
+/**
+ * One segment of a request path like "module:name=key1,key2"
+ * All members point into the parsed path. The keys are percent-decoded and
+ * stored one after another, each terminated by NUL.
+ */
+struct PathSegment {
+  char *module;
+  char *name;
+  char *keys;
+  int key_count;
+};
+
+int path_parse(char *path, struct PathSegment **segments);
+char *path_key_next(char *key);
+int path_segment_is(const struct PathSegment *segment, const char *module,
+                    const char *name);
 #endif  // RESTCONF_URL_H
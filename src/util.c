@@ -2,14 +2,15 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include "arena.h"
 #include "http.h"
 #include "vector.h"
 
 /**
  * @brief split a string into two parts at delimiter
  * @param split the string to be split
- * @param first the first part of the string
- * @param second the second part of the string
+ * @param first set to the first part of the string in the request arena
+ * @param second set to the second part of the string in the request arena
  * @param split_char the delimiter character
  * @return 0 if success else 1
  */
@@ -32,47 +33,45 @@ int split_pair_by_char(char *split, char **first, char **second,
 }
 
 /**
- * Duplicates a string
+ * Duplicates a string into the request arena
  * @param c the string to be duplicated
- * @return the duplicated string
+ * @return the duplicated string, it must not be freed
  */
 char *str_dup(const char *c) {
-  char *dup = malloc(strlen(c) + 1);
-
-  if (dup != NULL) strcpy(dup, c);
-
-  return dup;
+  return arena_strndup(request_arena(), c, strlen(c));
 }
 
 /**
- * @brief duplicates a string up to size
- * Taken from original strndup source
+ * @brief duplicates a string up to size into the request arena
  * @param s the string to be duplicated
  * @param n the size of the new string
- * @return the duplicated string
+ * @return the duplicated string, it must not be freed
  */
 char *strn_dup(const char *s, size_t n) {
-  size_t len = strnlen(s, n);
-  char *new = (char *)malloc(len + 1);
-  if (new == NULL) {
-    return NULL;
-  }
-  new[len] = '\0';
-  return (char *)memcpy(new, s, len);
+  return arena_strndup(request_arena(), s, n);
 }
 
 /**
- * @brief checks if string is in vector
- * @param vec the vector to be checked
- * @param value the string value
- * @return 1 if found else 0
+ * @brief encodes a tuple of strings into one string usable as a set key
+ * Every value is prefixed with its length so no value can run into the next.
+ * @param values the values of the tuple
+ * @param count the number of values
+ * @return the encoded tuple in the request arena or NULL
  */
-int is_in_vector(char **vec, char *value) {
-  for (size_t i = 0; i < vector_size(vec); i++) {
-    char *item = vec[i];
-    if (strcmp(item, value) == 0) {
-      return 1;
-    }
+char *tuple_encode(const char **values, size_t count) {
+  size_t length = 1;
+  char *tuple = NULL;
+  char *iter = NULL;
+  for (size_t i = 0; i < count; i++) {
+    length += strlen(values[i]) + 21;
   }
-  return 0;
+  if (!(tuple = arena_alloc(request_arena(), length))) {
+    return NULL;
+  }
+  iter = tuple;
+  for (size_t i = 0; i < count; i++) {
+    iter += sprintf(iter, "%zu:%s", strlen(values[i]), values[i]);
+  }
+  *iter = '\0';
+  return tuple;
 }
\ No newline at end of file
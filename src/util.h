@@ -7,6 +7,5 @@ int split_pair_by_char(char *split, char **first, char **second,
                        char split_char);
 char *str_dup(const char *c);
 char *strn_dup(const char *c, size_t to);
-
-int is_in_vector(char **vec, char *value);
+char *tuple_encode(const char **values, size_t count);
 #endif  // RESTCONF_UTIL_H
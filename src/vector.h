@@ -6,6 +6,20 @@
 #include <assert.h> /* for assert */
 #include <stddef.h> /* for size_t */
 #include <stdlib.h> /* for malloc/realloc/free */
+#include <string.h> /* for memcpy */
+
+/*
+ * The elements are preceded by three words: a flag that is set while the
+ * elements are kept in inline storage, the size and the capacity.
+ */
+
+/**
+ * @brief vector_is_inline - For internal use, checks if the vector uses
+ * inline storage that must not be passed to realloc or free
+ * @param vec - the vector
+ * @return non-zero if the storage is inline
+ */
+#define vector_is_inline(vec) ((vec) ? ((size_t *)(vec))[-3] : (size_t)0)
 
 /**
  * @brief vector_set_capacity - For internal use, sets the capacity variable of
@@ -65,22 +79,67 @@
  */
 #define vector_grow(vec, count)                                              \
   do {                                                                       \
-    if (!(vec)) {                                                            \
-      size_t *__p = malloc((count) * sizeof(*(vec)) + (sizeof(size_t) * 2)); \
+    if (!(vec) || vector_is_inline(vec)) {                                   \
+      size_t *__p = malloc((count) * sizeof(*(vec)) + (sizeof(size_t) * 3)); \
       assert(__p);                                                           \
-      (vec) = (void *)(&__p[2]);                                             \
+      __p[0] = 0;                                                            \
+      __p[1] = vector_size(vec);                                             \
+      if (vec) {                                                             \
+        memcpy(&__p[3], (vec), vector_size(vec) * sizeof(*(vec)));           \
+      }                                                                      \
+      (vec) = (void *)(&__p[3]);                                             \
       vector_set_capacity((vec), (count));                                   \
-      vector_set_size((vec), 0);                                             \
     } else {                                                                 \
-      size_t *__p1 = &((size_t *)(vec))[-2];                                 \
+      size_t *__p1 = &((size_t *)(vec))[-3];                                 \
       size_t *__p2 =                                                         \
-          realloc(__p1, ((count) * sizeof(*(vec)) + (sizeof(size_t) * 2)));  \
+          realloc(__p1, ((count) * sizeof(*(vec)) + (sizeof(size_t) * 3)));  \
       assert(__p2);                                                          \
-      (vec) = (void *)(&__p2[2]);                                            \
+      (vec) = (void *)(&__p2[3]);                                            \
       vector_set_capacity((vec), (count));                                   \
     }                                                                        \
   } while (0)
 
+/**
+ * @brief vector_reserve - ensures that the vector can hold at least <count>
+ * elements without growing
+ * @param vec - the vector
+ * @param count - the number of elements
+ * @return void
+ */
+#define vector_reserve(vec, count)        \
+  do {                                    \
+    if (vector_capacity(vec) < (count)) { \
+      vector_grow((vec), (count));        \
+    }                                     \
+  } while (0)
+
+/**
+ * @brief vector_inline_storage - declares storage for a vector of up to
+ * <count> elements, e.g. as local variable
+ * The vector only allocates once it grows beyond the storage.
+ * @param type - the element type
+ * @param count - the number of elements
+ */
+#define vector_inline_storage(type, count) \
+  struct {                                 \
+    size_t header[3];                      \
+    type items[count];                     \
+  }
+
+/**
+ * @brief vector_init_inline - makes an empty vector use inline storage
+ * @param vec - the vector
+ * @param storage - the storage declared by vector_inline_storage
+ * @return void
+ */
+#define vector_init_inline(vec, storage)                                    \
+  do {                                                                      \
+    (storage).header[0] = 1;                                                \
+    (storage).header[1] = 0;                                                \
+    (storage).header[2] = sizeof((storage).items) / sizeof(*(storage).items); \
+    (vec) = (storage).items;                                                \
+  } while (0)
+
 /**
  * @brief vector_pop_back - removes the last element from the vector
  * @param vec - the vector
@@ -118,8 +177,8 @@
  */
 #define vector_free(vec)                   \
   do {                                     \
-    if (vec) {                             \
-      size_t *p1 = &((size_t *)(vec))[-2]; \
+    if ((vec) && !vector_is_inline(vec)) { \
+      size_t *p1 = &((size_t *)(vec))[-3]; \
       free(p1);                            \
     }                                      \
   } while (0)
@@ -145,30 +204,14 @@
  * @param value - the value to add
  * @return void
  */
-#ifdef LOGARITHMIC_GROWTH
-
 #define vector_push_back(vec, value)                      \
   do {                                                    \
     size_t __cap = vector_capacity(vec);                  \
     if (__cap <= vector_size(vec)) {                      \
-      vector_grow((vec), !__cap ? __cap + 1 : __cap * 2); \
+      vector_grow((vec), __cap ? __cap * 2 : 4);          \
     }                                                     \
     vec[vector_size(vec)] = (value);                      \
     vector_set_size((vec), vector_size(vec) + 1);         \
   } while (0)
 
-#else
-
-#define vector_push_back(vec, value)              \
-  do {                                            \
-    size_t __cap = vector_capacity(vec);          \
-    if (__cap <= vector_size(vec)) {              \
-      vector_grow((vec), __cap + 1);              \
-    }                                             \
-    vec[vector_size(vec)] = (value);              \
-    vector_set_size((vec), vector_size(vec) + 1); \
-  } while (0)
-
-#endif
-
 #endif
\ No newline at end of file
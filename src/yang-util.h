@@ -10,10 +10,12 @@
 #define YANG_UCI_SECTION_NAME "section-name"
 #define YANG_UCI_SECTION "section"
 #define YANG_UCI_LEAF_AS_NAME "leaf-as-name"
+#define YANG_UCI_KEY_HASH_NAME "key-hash-name"
 #define YANG_KEYS "keys"
 #define YANG_UNIQUE "unique"
 #define YANG_MANDATORY "mandatory"
 #define YANG_LEAF_TYPE "leaf-type"
+#define YANG_VERIFY "verify"
 #define YANG_MAP "map"
 #define YANG_TYPE "type"
 #define YANG_LEAF "leaf"
@@ -1,5 +1,8 @@
 #include "yang-verify.h"
+#include <errno.h>
+#include <inttypes.h>
 #include <regex.h>
+#include "hash-set.h"
 #include "restconf-json.h"
 #include "restconf.h"
 #include "yang-util.h"
@@ -13,22 +16,37 @@ static int yang_verify_value_type(struct json_object* type, const char* value);
  * @return error if not verified
  */
 error yang_verify_leaf(struct json_object* leaf, struct json_object* yang) {
-  const char* value = NULL;
-  struct json_object* type = NULL;
   json_type value_type = json_object_get_type(leaf);
 
   if (value_type == json_type_object || value_type == json_type_array) {
     return INVALID_TYPE;
   }
+  return yang_verify_leaf_value(json_object_get_string(leaf), yang);
+}
+
+/**
+ * @brief verify the string form of a leaf value
+ * @param value the value, NULL for a JSON null
+ * @param yang the YANG leaf or leaf-list node
+ * @return error if not verified
+ */
+error yang_verify_leaf_value(const char* value, struct json_object* yang) {
+  struct json_object* type = NULL;
+  struct json_object* verify = NULL;
+  yang_validator validator = NULL;
 
   json_object_object_get_ex(yang, YANG_LEAF_TYPE, &type);
   if (!type) {
     return YANG_SCHEMA_ERROR;
   }
-
-  if (!(value = json_object_get_string(leaf))) {
+  if (!value) {
     return INVALID_TYPE;
   }
+  // the generator compiled the type of the leaf into a validator
+  if (json_object_object_get_ex(yang, YANG_VERIFY, &verify) &&
+      (validator = yang_validator_at(json_object_get_int(verify)))) {
+    return validator(value) ? INVALID_TYPE : RE_OK;
+  }
   if (yang_verify_value_type(type, value)) {
     return INVALID_TYPE;
   }
@@ -43,41 +61,62 @@ error yang_verify_leaf(struct json_object* leaf, struct json_object* yang) {
  */
 error yang_verify_leaf_list(struct json_object* list,
                             struct json_object* yang) {
-  struct json_object* type = NULL;
+  struct HashSet seen = INIT_HASH_SET();
+  error err = yang_verify_leaf_list_indexed(list, yang, &seen);
+  hash_set_free(&seen);
+  return err;
+}
+
+/**
+ * @brief verify new JSON leaf-list values against their type and the values
+ * already in the leaf-list
+ * @param list the JSON array of new values
+ * @param yang the YANG leaf-list node
+ * @param seen the values already in the leaf-list, new values are added
+ * @return error if not verified
+ */
+error yang_verify_leaf_list_indexed(struct json_object* list,
+                                    struct json_object* yang,
+                                    struct HashSet* seen) {
   json_type value_type = json_object_get_type(list);
   if (value_type != json_type_array) {
     return INVALID_TYPE;
   }
 
-  json_object_object_get_ex(yang, YANG_LEAF_TYPE, &type);
-  if (!type) {
-    return YANG_SCHEMA_ERROR;
-  }
   for (int i = 0; i < json_object_array_length(list); i++) {
-    const char* value = NULL;
     struct json_object* item = json_object_array_get_idx(list, i);
-    if (!(value = json_object_get_string(item))) {
-      return INVALID_TYPE;
-    }
-    if (yang_verify_value_type(type, value)) {
-      return INVALID_TYPE;
-    }
-    for (int compare = i + 1; compare < json_object_array_length(list);
-         compare++) {
-      const char* compare_value = NULL;
-      struct json_object* compare_item =
-          json_object_array_get_idx(list, compare);
-      if (!(compare_value = json_object_get_string(compare_item))) {
-        return INVALID_TYPE;
-      }
-      if (strcmp(value, compare_value) == 0) {
-        return IDENTICAL_KEYS;
-      }
+    error err = yang_verify_leaf_list_value(json_object_get_string(item), yang,
+                                            seen);
+    if (err != RE_OK) {
+      return err;
     }
   }
   return RE_OK;
 }
 
+/**
+ * @brief verify one leaf-list value against its type and the values before it
+ * @param value the value, NULL for a JSON null
+ * @param yang the YANG leaf-list node
+ * @param seen the values already in the leaf-list, the value is added
+ * @return error if not verified
+ */
+error yang_verify_leaf_list_value(const char* value, struct json_object* yang,
+                                  struct HashSet* seen) {
+  int added;
+  error err = yang_verify_leaf_value(value, yang);
+  if (err != RE_OK) {
+    return err;
+  }
+  if ((added = hash_set_add(seen, value)) < 0) {
+    return INTERNAL;
+  }
+  if (!added) {
+    return IDENTICAL_KEYS;
+  }
+  return RE_OK;
+}
+
 /**
  * @brief verify JSON type again YANG type
  * @param type the yang_type
@@ -142,6 +181,198 @@ int yang_mandatory(struct json_object* yang) {
   return 0;
 }
 
+/**
+ * @brief verify that a value is a decimal integer in a range
+ * @param value the string value
+ * @param from the lowest allowed integer
+ * @param to the highest allowed integer
+ * @return 1 if error else 0
+ */
+int yang_verify_integer(const char* value, intmax_t from, intmax_t to) {
+  char* end = NULL;
+  intmax_t integer;
+  errno = 0;
+  integer = strtoimax(value, &end, 10);
+  return errno || end == value || *end != '\0' || integer < from ||
+         integer > to;
+}
+
+/**
+ * @brief verify that a value is an unsigned decimal integer in a range
+ * @param value the string value
+ * @param from the lowest allowed integer
+ * @param to the highest allowed integer
+ * @return 1 if error else 0
+ */
+int yang_verify_unsigned(const char* value, uintmax_t from, uintmax_t to) {
+  char* end = NULL;
+  uintmax_t integer;
+  if (strchr(value, '-')) {
+    return 1;
+  }
+  errno = 0;
+  integer = strtoumax(value, &end, 10);
+  return errno || end == value || *end != '\0' || integer < from ||
+         integer > to;
+}
+
+/**
+ * @brief verify that a value is a decimal64 in a range
+ * The value is compared as the integer it is scaled to by the fraction
+ * digits, so no precision is lost.
+ * @param value the string value
+ * @param fraction_digits the fraction digits of the type
+ * @param from the lowest allowed scaled value
+ * @param to the highest allowed scaled value
+ * @return 1 if error else 0
+ */
+int yang_verify_decimal64(const char* value, int fraction_digits,
+                          intmax_t from, intmax_t to) {
+  int negative = *value == '-';
+  int digits = 0;
+  // the digits after the point, -1 before it
+  int fraction = -1;
+  intmax_t scaled = 0;
+
+  if (*value == '-' || *value == '+') {
+    value++;
+  }
+  for (; *value; value++) {
+    if (*value == '.' && fraction < 0 && digits > 0) {
+      fraction = 0;
+      continue;
+    }
+    if (*value < '0' || *value > '9' || fraction == fraction_digits) {
+      return 1;
+    }
+    // summed up negative, the lowest value has no positive counterpart
+    if (scaled < (INTMAX_MIN + (*value - '0')) / 10) {
+      return 1;
+    }
+    scaled = scaled * 10 - (*value - '0');
+    digits++;
+    if (fraction >= 0) {
+      fraction++;
+    }
+  }
+  if (digits == 0 || fraction == 0) {
+    return 1;
+  }
+  for (fraction = fraction < 0 ? 0 : fraction; fraction < fraction_digits;
+       fraction++) {
+    if (scaled < INTMAX_MIN / 10) {
+      return 1;
+    }
+    scaled *= 10;
+  }
+  if (!negative) {
+    if (scaled == INTMAX_MIN) {
+      return 1;
+    }
+    scaled = -scaled;
+  }
+  return scaled < from || scaled > to;
+}
+
+/**
+ * @brief verify that a value is a boolean
+ * @param value the string value
+ * @return 1 if error else 0
+ */
+int yang_verify_boolean(const char* value) {
+  return strcmp(value, "true") != 0 && strcmp(value, "false") != 0;
+}
+
+/**
+ * @brief verify a value against a pattern of a compiled validator
+ * The pattern is compiled once and kept for the following values.
+ * @param pattern the pattern
+ * @param value the string value
+ * @return 1 if error else 0
+ */
+int yang_verify_pattern(struct YangPattern* pattern, const char* value) {
+  if (pattern->state == 0) {
+    pattern->state =
+        regcomp(&pattern->compiled, pattern->regex, REG_EXTENDED | REG_NOSUB)
+            ? -1
+            : 1;
+  }
+  return pattern->state < 0 ||
+         regexec(&pattern->compiled, value, 0, NULL, 0) != 0;
+}
+
+/**
+ * @brief find the slot of a name in a name set
+ * The hash is FNV-1a with the seed of the set as offset basis, like in the
+ * generator.
+ * @param set the name set
+ * @param name the name, it does not have to be terminated
+ * @param length the length of the name
+ * @return the slot or -1 if the name is not in the set
+ */
+static long name_set_find(const struct YangNameSet* set, const char* name,
+                          size_t length) {
+  uint32_t hash = set->seed;
+  const char* candidate = NULL;
+  for (size_t i = 0; i < length; i++) {
+    hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+  }
+  candidate = set->slots[hash % set->size];
+  if (!candidate || strlen(candidate) != length ||
+      strncmp(candidate, name, length) != 0) {
+    return -1;
+  }
+  return hash % set->size;
+}
+
+/**
+ * @brief verify that a value is one of the enums of an enumeration
+ * @param set the names of the enums
+ * @param value the string value
+ * @return 1 if error else 0
+ */
+int yang_verify_enum(const struct YangNameSet* set, const char* value) {
+  return name_set_find(set, value, strlen(value)) < 0;
+}
+
+/**
+ * @brief verify that a value is a space separated set of bits
+ * Every bit may only be set once.
+ * @param set the names of the bits
+ * @param value the string value
+ * @return 1 if error else 0
+ */
+int yang_verify_bits(const struct YangNameSet* set, const char* value) {
+  unsigned char set_bits[set->size];
+  memset(set_bits, 0, set->size);
+  while (*value) {
+    size_t length = strcspn(value, " ");
+    long slot;
+    if (length == 0) {
+      value++;
+      continue;
+    }
+    if ((slot = name_set_find(set, value, length)) < 0 || set_bits[slot]) {
+      return 1;
+    }
+    set_bits[slot] = 1;
+    value += length;
+  }
+  return 0;
+}
+
+/**
+ * @brief verify that a value is an identity derived from the base identity
+ * The value may be qualified with the name of its module.
+ * @param set the names of the derived identities
+ * @param value the string value
+ * @return 1 if error else 0
+ */
+int yang_verify_identity(const struct YangNameSet* set, const char* value) {
+  const char* name = strchr(value, ':') ? strchr(value, ':') + 1 : value;
+  return name_set_find(set, name, strlen(name)) < 0;
+}
+
 /**
  * @brief verify string with regex
  * @param regex the regex
@@ -3,11 +3,52 @@
 
 #include <generated/yang.h>
 #include <json-c/json.h>
+#include <regex.h>
+#include <stdint.h>
 #include "error.h"
+#include "hash-set.h"
+
+/**
+ * A pattern of a compiled validator, it is compiled on its first use
+ */
+struct YangPattern {
+  const char* regex;
+  int state;
+  regex_t compiled;
+};
+
+#define INIT_YANG_PATTERN(regex) \
+  { (regex), 0 }
+
+/**
+ * A perfect hash table of the names of enums, bits or identities
+ * Every name hashes to its own slot with the seed, so looking up a name
+ * compares it to one slot at most.
+ */
+struct YangNameSet {
+  const char* const* slots;
+  size_t size;
+  uint32_t seed;
+};
 
 error yang_verify_leaf(struct json_object* leaf, struct json_object* yang);
+error yang_verify_leaf_value(const char* value, struct json_object* yang);
 error yang_verify_leaf_list(struct json_object* list, struct json_object* yang);
+error yang_verify_leaf_list_indexed(struct json_object* list,
+                                    struct json_object* yang,
+                                    struct HashSet* seen);
+error yang_verify_leaf_list_value(const char* value, struct json_object* yang,
+                                  struct HashSet* seen);
 int yang_verify_json_type(yang_type type, json_type val_type);
 int yang_mandatory(struct json_object* yang);
+int yang_verify_integer(const char* value, intmax_t from, intmax_t to);
+int yang_verify_unsigned(const char* value, uintmax_t from, uintmax_t to);
+int yang_verify_decimal64(const char* value, int fraction_digits,
+                          intmax_t from, intmax_t to);
+int yang_verify_boolean(const char* value);
+int yang_verify_pattern(struct YangPattern* pattern, const char* value);
+int yang_verify_enum(const struct YangNameSet* set, const char* value);
+int yang_verify_bits(const struct YangNameSet* set, const char* value);
+int yang_verify_identity(const struct YangNameSet* set, const char* value);
 
 #endif  // RESTCONF_YANG_VERIFY_H
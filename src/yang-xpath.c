@@ -0,0 +1,571 @@
+#include "yang-xpath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "generated/yang.h"
+#include "arena.h"
+#include "hash-set.h"
+#include "uci/backend.h"
+#include "uci/methods.h"
+#include "util.h"
+#include "vector.h"
+
+enum xpath_type { XPATH_NODES, XPATH_TEXT, XPATH_NUM, XPATH_BOOL };
+
+/**
+ * A value on the stack, the nodes are the values of a path
+ */
+struct XPathValue {
+  enum xpath_type type;
+  const char **nodes;
+  const char *string;
+  double number;
+};
+
+/**
+ * A section of the configuration after the request, either a named section
+ * or the anonymous section at an index of its type
+ */
+struct XPathSection {
+  const char *package;
+  const char *name;
+  const char *type;
+  int index;
+};
+
+/**
+ * A package of the snapshot the constraints are evaluated against
+ */
+struct XPathPackage {
+  const char *name;
+  struct UciMap map;
+};
+
+/**
+ * The state a constraint is evaluated in
+ */
+struct XPathContext {
+  struct XPathPackage **packages;
+  const struct YangConstraints *table;
+  UciWritePair **write_list;
+  struct XPathSection section;
+};
+
+/**
+ * @brief get the section a write goes to
+ * @param cmd the write
+ * @return the section
+ */
+static struct XPathSection write_section(UciWritePair *cmd) {
+  struct XPathSection section = {cmd->path.package, NULL,
+                                 cmd->path.section_type, cmd->path.index};
+  if (*cmd->path.section) {
+    section.name = cmd->path.section;
+    section.index = -1;
+  }
+  return section;
+}
+
+/**
+ * @brief check if a write sets a value of an option in a section
+ * @param cmd the write
+ * @param section the section
+ * @param option the option
+ * @return 1 if it does else 0
+ */
+static int write_sets(UciWritePair *cmd, const struct XPathSection *section,
+                      const char *option) {
+  if (cmd->type == container || !cmd->value ||
+      strcmp(cmd->path.option, option) != 0 ||
+      strcmp(cmd->path.package, section->package) != 0) {
+    return 0;
+  }
+  if (section->name) {
+    return strcmp(cmd->path.section, section->name) == 0;
+  }
+  return !*cmd->path.section &&
+         strcmp(cmd->path.section_type, section->type) == 0 &&
+         cmd->path.index == section->index;
+}
+
+/**
+ * @brief get a package of the snapshot, it is indexed on first use
+ * @param eval the evaluation context
+ * @param package the name of the package
+ * @return the package, without sections if it does not exist, or NULL on
+ * error
+ */
+static struct UciMap *snapshot_package(struct XPathContext *eval,
+                                       const char *package) {
+  struct XPathPackage *loaded = NULL;
+  for (size_t i = 0; i < vector_size(eval->packages); i++) {
+    if (strcmp(eval->packages[i]->name, package) == 0) {
+      return &eval->packages[i]->map;
+    }
+  }
+  if (!(loaded = arena_alloc(request_arena(), sizeof(*loaded))) ||
+      datastore_backend()->sections(package, &loaded->map)) {
+    return NULL;
+  }
+  loaded->name = package;
+  vector_push_back(eval->packages, loaded);
+  return &loaded->map;
+}
+
+/**
+ * @brief add the values of an option of a snapshot section to a node-set
+ * @param section the section or NULL
+ * @param option the option
+ * @param nodes the node-set
+ */
+static void push_option(const struct UciMapSection *section,
+                        const char *option, const char ***nodes) {
+  struct UciMapOption *o = section ? uci_map_option(section, option) : NULL;
+  for (size_t i = 0; o && i < vector_size(o->values); i++) {
+    const char *value = uci_slice_dup(o->values[i]);
+    if (value) {
+      vector_push_back((*nodes), value);
+    }
+  }
+}
+
+/**
+ * @brief add the values an option has in a section after the request to a
+ * node-set, the writes of the request replace the values of the snapshot
+ * @param eval the evaluation context
+ * @param section the section
+ * @param option the option
+ * @param nodes the node-set
+ */
+static void section_values(struct XPathContext *eval,
+                           const struct XPathSection *section,
+                           const char *option, const char ***nodes) {
+  struct UciMap *package = NULL;
+  int written = 0;
+  int index = 0;
+
+  for (size_t i = 0; i < vector_size(eval->write_list); i++) {
+    if (write_sets(eval->write_list[i], section, option)) {
+      vector_push_back((*nodes), eval->write_list[i]->value);
+      written = 1;
+    }
+  }
+  if (written || !(package = snapshot_package(eval, section->package))) {
+    return;
+  }
+  if (section->name) {
+    push_option(uci_map_section(package, section->name), option, nodes);
+    return;
+  }
+  for (size_t i = 0; i < vector_size(package->sections); i++) {
+    const struct UciMapSection *s = &package->sections[i];
+    if (uci_slice_is(s->type, section->type) && index++ == section->index) {
+      push_option(s, option, nodes);
+      return;
+    }
+  }
+}
+
+/**
+ * @brief get the values of a path after the request
+ * @param eval the evaluation context
+ * @param path the path
+ * @param nodes the node-set
+ * @return 0 if success else 1
+ */
+static int path_values(struct XPathContext *eval, const struct XPathPath *path,
+                       const char ***nodes) {
+  struct HashSet seen = INIT_HASH_SET();
+  struct UciMap *package = NULL;
+  int index = 0;
+  int retval = 1;
+
+  if (path->local) {
+    section_values(eval, &eval->section, path->option, nodes);
+    return 0;
+  }
+  if (path->section_name) {
+    struct XPathSection named = {path->package, path->section_name, NULL, -1};
+    section_values(eval, &named, path->option, nodes);
+    return 0;
+  }
+  if ((package = snapshot_package(eval, path->package))) {
+    for (size_t i = 0; i < vector_size(package->sections); i++) {
+      const struct UciMapSection *s = &package->sections[i];
+      struct XPathSection section = {path->package, NULL, path->section,
+                                     index};
+      char key[32];
+      if (!uci_slice_is(s->type, path->section)) {
+        continue;
+      }
+      snprintf(key, sizeof(key), "#%d", index++);
+      if (!s->anonymous) {
+        if (!(section.name = uci_slice_dup(s->name))) {
+          goto done;
+        }
+        section.index = -1;
+      }
+      if (hash_set_add(&seen, section.name ? section.name : key) < 0) {
+        goto done;
+      }
+      section_values(eval, &section, path->option, nodes);
+    }
+  }
+  // sections that are created by the request
+  for (size_t i = 0; i < vector_size(eval->write_list); i++) {
+    UciWritePair *cmd = eval->write_list[i];
+    struct XPathSection section = write_section(cmd);
+    char key[32];
+    int added;
+    if (cmd->type == container || !cmd->value ||
+        strcmp(cmd->path.package, path->package) != 0 ||
+        strcmp(cmd->path.section_type, path->section) != 0 ||
+        strcmp(cmd->path.option, path->option) != 0) {
+      continue;
+    }
+    snprintf(key, sizeof(key), "#%d", section.index);
+    if ((added = hash_set_add(&seen, section.name ? section.name : key)) < 0) {
+      goto done;
+    }
+    if (added) {
+      section_values(eval, &section, path->option, nodes);
+    }
+  }
+  retval = 0;
+done:
+  hash_set_free(&seen);
+  return retval;
+}
+
+/**
+ * @brief convert the text of a node or string to a number
+ * @param text the text
+ * @return the number or NaN if it is not one
+ */
+static double text_number(const char *text) {
+  char *end = NULL;
+  double number = strtod(text, &end);
+  if (end == text) {
+    return NAN;
+  }
+  while (*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r') {
+    end++;
+  }
+  return *end ? NAN : number;
+}
+
+static double to_number(const struct XPathValue *value) {
+  switch (value->type) {
+    case XPATH_NODES:
+      return vector_empty(value->nodes) ? NAN : text_number(value->nodes[0]);
+    case XPATH_TEXT:
+      return text_number(value->string);
+    default:
+      return value->number;
+  }
+}
+
+static int to_boolean(const struct XPathValue *value) {
+  switch (value->type) {
+    case XPATH_NODES:
+      return !vector_empty(value->nodes);
+    case XPATH_TEXT:
+      return *value->string != '\0';
+    case XPATH_NUM:
+      return value->number != 0 && !isnan(value->number);
+    default:
+      return value->number != 0;
+  }
+}
+
+/**
+ * @brief convert a value to a string
+ * @param value the value
+ * @param buffer the buffer numbers are written to
+ * @param size the size of the buffer
+ * @return the string
+ */
+static const char *to_string(const struct XPathValue *value, char *buffer,
+                             size_t size) {
+  switch (value->type) {
+    case XPATH_NODES:
+      return vector_empty(value->nodes) ? "" : value->nodes[0];
+    case XPATH_TEXT:
+      return value->string;
+    case XPATH_BOOL:
+      return value->number ? "true" : "false";
+    default:
+      if (isnan(value->number)) {
+        return "NaN";
+      }
+      snprintf(buffer, size,
+               value->number == floor(value->number) ? "%.0f" : "%g",
+               value->number);
+      return buffer;
+  }
+}
+
+/**
+ * @brief compare two values that are not node-sets
+ * @param op the comparison
+ * @param a the left value
+ * @param b the right value
+ * @return the result of the comparison
+ */
+static int compare_atoms(int op, const struct XPathValue *a,
+                         const struct XPathValue *b) {
+  double x, y;
+  int equal;
+  if (op == XPATH_EQ || op == XPATH_NE) {
+    if (a->type == XPATH_BOOL || b->type == XPATH_BOOL) {
+      equal = to_boolean(a) == to_boolean(b);
+    } else if (a->type == XPATH_NUM || b->type == XPATH_NUM) {
+      equal = to_number(a) == to_number(b);
+    } else {
+      equal = strcmp(a->string, b->string) == 0;
+    }
+    return op == XPATH_EQ ? equal : !equal;
+  }
+  x = to_number(a);
+  y = to_number(b);
+  switch (op) {
+    case XPATH_LT:
+      return x < y;
+    case XPATH_LE:
+      return x <= y;
+    case XPATH_GT:
+      return x > y;
+    default:
+      return x >= y;
+  }
+}
+
+/**
+ * @brief compare two values, a node-set matches if one of its nodes does
+ * @param op the comparison
+ * @param a the left value
+ * @param b the right value
+ * @return the result of the comparison
+ */
+static int compare(int op, const struct XPathValue *a,
+                   const struct XPathValue *b) {
+  struct XPathValue left = *a;
+  struct XPathValue right = *b;
+
+  if (a->type == XPATH_NODES && b->type == XPATH_BOOL) {
+    left = (struct XPathValue){XPATH_BOOL, NULL, NULL, to_boolean(a)};
+  } else if (b->type == XPATH_NODES && a->type == XPATH_BOOL) {
+    right = (struct XPathValue){XPATH_BOOL, NULL, NULL, to_boolean(b)};
+  } else if (a->type == XPATH_NODES) {
+    for (size_t i = 0; i < vector_size(a->nodes); i++) {
+      left = (struct XPathValue){XPATH_TEXT, NULL, a->nodes[i], 0};
+      if (compare(op, &left, b)) {
+        return 1;
+      }
+    }
+    return 0;
+  } else if (b->type == XPATH_NODES) {
+    for (size_t i = 0; i < vector_size(b->nodes); i++) {
+      right = (struct XPathValue){XPATH_TEXT, NULL, b->nodes[i], 0};
+      if (compare(op, a, &right)) {
+        return 1;
+      }
+    }
+    return 0;
+  }
+  return compare_atoms(op, &left, &right);
+}
+
+/**
+ * @brief replace a value on the stack
+ * @param value the value, its node-set is freed
+ * @param type the type of the new value
+ * @param number the number or boolean of the new value
+ */
+static void set_value(struct XPathValue *value, enum xpath_type type,
+                      double number) {
+  vector_free(value->nodes);
+  *value = (struct XPathValue){type, NULL, NULL, number};
+}
+
+/**
+ * @brief count the characters of an UTF-8 string
+ * @param string the string
+ * @return the number of characters
+ */
+static size_t utf8_length(const char *string) {
+  size_t length = 0;
+  for (; *string; string++) {
+    length += ((unsigned char)*string & 0xc0) != 0x80;
+  }
+  return length;
+}
+
+/**
+ * @brief run the code of a constraint
+ * @param eval the evaluation context with the section of the constrained node
+ * @param constraint the constraint
+ * @return 1 if it is satisfied, 0 if not and -1 on error
+ */
+static int evaluate(struct XPathContext *eval,
+                    const struct YangConstraint *constraint) {
+  struct XPathValue stack[XPATH_MAX_STACK];
+  size_t top = 0;
+  int result = -1;
+
+  for (size_t i = 0; i < constraint->length; i++) {
+    struct XPathOp op = constraint->code[i];
+    struct XPathValue *a = top > 1 ? &stack[top - 2] : NULL;
+    struct XPathValue *b = top > 0 ? &stack[top - 1] : NULL;
+    char first[32], second[32];
+
+    // only these operations push, all others keep or shrink the stack
+    if ((op.op == XPATH_PATH || op.op == XPATH_STRING ||
+         op.op == XPATH_NUMBER || op.op == XPATH_TRUE ||
+         op.op == XPATH_FALSE) &&
+        top == XPATH_MAX_STACK) {
+      goto done;
+    }
+    switch (op.op) {
+      case XPATH_PATH:
+        stack[top] = (struct XPathValue){XPATH_NODES, NULL, NULL, 0};
+        if (path_values(eval, &eval->table->paths[op.arg],
+                        &stack[top++].nodes)) {
+          goto done;
+        }
+        break;
+      case XPATH_STRING:
+        stack[top++] = (struct XPathValue){XPATH_TEXT, NULL,
+                                           eval->table->strings[op.arg], 0};
+        break;
+      case XPATH_NUMBER:
+        stack[top++] = (struct XPathValue){XPATH_NUM, NULL, NULL,
+                                           eval->table->numbers[op.arg]};
+        break;
+      case XPATH_TRUE:
+      case XPATH_FALSE:
+        stack[top++] =
+            (struct XPathValue){XPATH_BOOL, NULL, NULL, op.op == XPATH_TRUE};
+        break;
+      case XPATH_NEG:
+        set_value(b, XPATH_NUM, -to_number(b));
+        break;
+      case XPATH_NOT:
+        set_value(b, XPATH_BOOL, !to_boolean(b));
+        break;
+      case XPATH_COUNT:
+        set_value(b, XPATH_NUM, vector_size(b->nodes));
+        break;
+      case XPATH_STRING_LENGTH:
+        set_value(b, XPATH_NUM,
+                  utf8_length(to_string(b, first, sizeof(first))));
+        break;
+      default: {
+        double number = 0;
+        enum xpath_type type = XPATH_BOOL;
+        if (op.op == XPATH_OR) {
+          number = to_boolean(a) || to_boolean(b);
+        } else if (op.op == XPATH_AND) {
+          number = to_boolean(a) && to_boolean(b);
+        } else if (op.op == XPATH_ADD || op.op == XPATH_SUB) {
+          type = XPATH_NUM;
+          number = op.op == XPATH_ADD ? to_number(a) + to_number(b)
+                                      : to_number(a) - to_number(b);
+        } else if (op.op == XPATH_CONTAINS) {
+          number = strstr(to_string(a, first, sizeof(first)),
+                          to_string(b, second, sizeof(second))) != NULL;
+        } else if (op.op == XPATH_STARTS_WITH) {
+          const char *prefix = to_string(b, second, sizeof(second));
+          number = strncmp(to_string(a, first, sizeof(first)), prefix,
+                           strlen(prefix)) == 0;
+        } else {
+          number = compare(op.op, a, b);
+        }
+        set_value(b, XPATH_BOOL, 0);
+        set_value(a, type, number);
+        top--;
+        break;
+      }
+    }
+  }
+  if (top > 0) {
+    result = to_boolean(&stack[top - 1]);
+  }
+done:
+  while (top > 0) {
+    vector_free(stack[--top].nodes);
+  }
+  return result;
+}
+
+/**
+ * @brief check if a write sets an option of a constrained node
+ * @param constraint the constraint
+ * @param cmd the write
+ * @return 1 if it does else 0
+ */
+static int constraint_applies(const struct YangConstraint *constraint,
+                              UciWritePair *cmd) {
+  if (cmd->type == container || !cmd->value ||
+      strcmp(cmd->path.package, constraint->package) != 0) {
+    return 0;
+  }
+  if (constraint->section_name
+          ? strcmp(cmd->path.section, constraint->section_name) != 0
+          : strcmp(cmd->path.section_type, constraint->section) != 0) {
+    return 0;
+  }
+  for (const char *const *option = constraint->options; *option; option++) {
+    if (strcmp(cmd->path.option, *option) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief check the must and when statements of the nodes a request writes
+ * Each constraint is evaluated once per section against the snapshot of the
+ * datastore with the writes of the request applied.
+ * @param write_list the writes of the request
+ * @return MUST_VIOLATION or WHEN_VIOLATION if a constraint is not satisfied
+ * else RE_OK
+ */
+error yang_constraints_verify(UciWritePair **write_list) {
+  const struct YangConstraints *table = yang_constraints();
+  struct XPathContext eval = {NULL, table, write_list, {NULL, NULL, NULL, 0}};
+  struct HashSet checked = INIT_HASH_SET();
+  error err = RE_OK;
+
+  for (size_t i = 0; i < vector_size(write_list) && err == RE_OK; i++) {
+    const struct YangConstraint *constraint = table->constraints;
+    for (; constraint->package && err == RE_OK; constraint++) {
+      char key[512];
+      int result;
+      if (!constraint_applies(constraint, write_list[i])) {
+        continue;
+      }
+      eval.section = write_section(write_list[i]);
+      snprintf(key, sizeof(key), "%ld/%s/%d",
+               (long)(constraint - table->constraints),
+               eval.section.name ? eval.section.name : eval.section.type,
+               eval.section.index);
+      if ((result = hash_set_add(&checked, key)) <= 0) {
+        err = result < 0 ? INTERNAL : RE_OK;
+        continue;
+      }
+      if ((result = evaluate(&eval, constraint)) < 0) {
+        err = INTERNAL;
+      } else if (!result) {
+        err = constraint->when ? WHEN_VIOLATION : MUST_VIOLATION;
+      }
+    }
+  }
+  hash_set_free(&checked);
+  for (size_t i = 0; i < vector_size(eval.packages); i++) {
+    uci_map_free(&eval.packages[i]->map);
+  }
+  vector_free(eval.packages);
+  return err;
+}
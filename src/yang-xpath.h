@@ -0,0 +1,83 @@
+#ifndef RESTCONF_YANG_XPATH_H
+#define RESTCONF_YANG_XPATH_H
+
+#include <stddef.h>
+#include "error.h"
+#include "uci/cmd.h"
+
+#define XPATH_MAX_STACK 16
+
+/**
+ * The instructions of the stack machine the must and when statements are
+ * compiled to, the argument of a constant or path is its index in the table
+ */
+enum xpath_op {
+  XPATH_PATH,
+  XPATH_STRING,
+  XPATH_NUMBER,
+  XPATH_TRUE,
+  XPATH_FALSE,
+  XPATH_OR,
+  XPATH_AND,
+  XPATH_EQ,
+  XPATH_NE,
+  XPATH_LT,
+  XPATH_LE,
+  XPATH_GT,
+  XPATH_GE,
+  XPATH_ADD,
+  XPATH_SUB,
+  XPATH_NEG,
+  XPATH_NOT,
+  XPATH_COUNT,
+  XPATH_STRING_LENGTH,
+  XPATH_CONTAINS,
+  XPATH_STARTS_WITH
+};
+
+struct XPathOp {
+  unsigned char op;
+  unsigned short arg;
+};
+
+/**
+ * A path of an expression resolved to the UCI option of its leaf
+ * A local path is read from the section of the constrained node, any other
+ * one from all sections of its type or its named section.
+ */
+struct XPathPath {
+  const char *package;
+  const char *section;
+  const char *section_name;
+  const char *option;
+  int local;
+};
+
+/**
+ * A compiled must or when statement
+ * It is checked for every section the request writes one of its options to.
+ */
+struct YangConstraint {
+  const char *package;
+  const char *section;
+  const char *section_name;
+  const char *const *options;
+  int when;
+  const struct XPathOp *code;
+  size_t length;
+};
+
+/**
+ * The constraints, terminated by one without package, and the constants
+ * their code refers to
+ */
+struct YangConstraints {
+  const struct YangConstraint *constraints;
+  const struct XPathPath *paths;
+  const char *const *strings;
+  const double *numbers;
+};
+
+error yang_constraints_verify(UciWritePair **write_list);
+
+#endif  // RESTCONF_YANG_XPATH_H
@@ -0,0 +1,227 @@
+#include <json-c/json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "uci/backend.h"
+#include "util.h"
+#include "vector.h"
+
+#define TEST_SEED \
+  "{\"school\": {\"main\": {\".type\": \"settings\", \"campus\": \"North\"}}}"
+#define TEST_WRITERS 16
+
+/**
+ * @brief write the seed the backend starts from
+ * @return 0 if success else 1
+ */
+static int write_seed() {
+  FILE *file = fopen(RESTCONF_MEMORY_SEED, "w");
+  if (!file) {
+    return 1;
+  }
+  fputs(TEST_SEED, file);
+  return fclose(file) != 0;
+}
+
+/**
+ * @brief read an option of the settings section from the seed file
+ * @param seed the seed that was read, released by the caller
+ * @param option the name of the option
+ * @return the option or NULL if it does not exist
+ */
+static struct json_object *seed_option(struct json_object **seed,
+                                       const char *option) {
+  struct json_object *package = NULL;
+  struct json_object *section = NULL;
+  struct json_object *value = NULL;
+
+  if (!(*seed = json_object_from_file(RESTCONF_MEMORY_SEED)) ||
+      !json_object_object_get_ex(*seed, "school", &package) ||
+      !json_object_object_get_ex(package, "main", &section) ||
+      !json_object_object_get_ex(section, option, &value)) {
+    return NULL;
+  }
+  return value;
+}
+
+/**
+ * @brief check the value of a string option in the seed file
+ * @param option the name of the option
+ * @param expected the expected value
+ * @return 0 if it has the value else 1
+ */
+static int check_option(const char *option, const char *expected) {
+  struct json_object *seed = NULL;
+  struct json_object *value = seed_option(&seed, option);
+  int failed = !value || strcmp(json_object_get_string(value), expected) != 0;
+
+  if (failed) {
+    fprintf(stderr, "%s is %s instead of %s\n", option,
+            value ? json_object_get_string(value) : "missing", expected);
+  }
+  json_object_put(seed);
+  return failed;
+}
+
+/**
+ * @brief change the store the way one request does and commit or revert
+ * Every request is a process of its own, so the change is made in a child.
+ * @param option the option of the settings section to set
+ * @param value the value
+ * @param commit commit the change instead of reverting it
+ * @return the process id of the child or -1
+ */
+static pid_t request(const char *option, const char *value, int commit) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    const struct DatastoreBackend *backend = datastore_backend();
+    char path[128];
+    char **package_list = NULL;
+    int failed;
+
+    snprintf(path, sizeof(path), "school.main.%s", option);
+    vector_push_back(package_list, str_dup("school"));
+    failed = backend->lock() || backend->set(str_dup(path), value) ||
+             backend->add_list(str_dup("school.main.writers"), value);
+    failed = failed || (commit ? backend->commit(package_list)
+                               : backend->revert(package_list));
+    _exit(failed);
+  }
+  return pid;
+}
+
+/**
+ * @brief increment a counter of the settings section the way one request
+ * checks the store before it changes it
+ * @return the process id of the child or -1
+ */
+static pid_t increment() {
+  pid_t pid = fork();
+  if (pid == 0) {
+    const struct DatastoreBackend *backend = datastore_backend();
+    char value[32] = "0";
+    char **package_list = NULL;
+    int failed;
+
+    vector_push_back(package_list, str_dup("school"));
+    failed = backend->lock();
+    // a missing counter reads as 0
+    backend->read_option(str_dup("school.main.counter"), value, sizeof(value));
+    snprintf(value, sizeof(value), "%d", atoi(value) + 1);
+    failed = failed || backend->set(str_dup("school.main.counter"), value) ||
+             backend->commit(package_list);
+    _exit(failed);
+  }
+  return pid;
+}
+
+/**
+ * @brief wait for a request
+ * @param pid the process id of the request
+ * @return 0 if it succeeded else 1
+ */
+static int wait_request(pid_t pid) {
+  int status = 0;
+  return pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) ||
+         WEXITSTATUS(status) != 0;
+}
+
+/**
+ * @brief a committed change is written to the seed
+ */
+static int test_commit() {
+  return wait_request(request("campus", "South", 1)) ||
+         check_option("campus", "South");
+}
+
+/**
+ * @brief a reverted change is not written to the seed
+ */
+static int test_revert() {
+  return wait_request(request("campus", "East", 0)) ||
+         check_option("campus", "South");
+}
+
+/**
+ * @brief concurrent requests do not write over each others changes
+ */
+static int test_concurrent_writers() {
+  pid_t writers[TEST_WRITERS];
+  struct json_object *seed = NULL;
+  struct json_object *list = NULL;
+  int failed = 0;
+
+  if (write_seed()) {
+    return 1;
+  }
+  for (int i = 0; i < TEST_WRITERS; i++) {
+    char option[16];
+    snprintf(option, sizeof(option), "writer%d", i);
+    writers[i] = request(option, option, 1);
+  }
+  for (int i = 0; i < TEST_WRITERS; i++) {
+    failed |= wait_request(writers[i]);
+  }
+  for (int i = 0; !failed && i < TEST_WRITERS; i++) {
+    char option[16];
+    snprintf(option, sizeof(option), "writer%d", i);
+    failed = check_option(option, option);
+  }
+  list = seed_option(&seed, "writers");
+  if (!failed && (json_object_get_type(list) != json_type_array ||
+                  json_object_array_length(list) != TEST_WRITERS)) {
+    fprintf(stderr, "the list has %zu of %d values\n",
+            list ? (size_t)json_object_array_length(list) : 0, TEST_WRITERS);
+    failed = 1;
+  }
+  json_object_put(seed);
+  return failed;
+}
+
+/**
+ * @brief concurrent requests check the store they change
+ */
+static int test_concurrent_checks() {
+  pid_t writers[TEST_WRITERS];
+  char expected[16];
+  int failed = 0;
+
+  if (write_seed()) {
+    return 1;
+  }
+  for (int i = 0; i < TEST_WRITERS; i++) {
+    writers[i] = increment();
+  }
+  for (int i = 0; i < TEST_WRITERS; i++) {
+    failed |= wait_request(writers[i]);
+  }
+  snprintf(expected, sizeof(expected), "%d", TEST_WRITERS);
+  return failed || check_option("counter", expected);
+}
+
+int main(void) {
+  static const struct {
+    const char *name;
+    int (*run)();
+  } tests[] = {{"commit", test_commit},
+               {"revert", test_revert},
+               {"concurrent writers", test_concurrent_writers},
+               {"concurrent checks", test_concurrent_checks}};
+  int failed = 0;
+
+  if (strcmp(datastore_backend()->name, "memory") != 0 || write_seed()) {
+    fprintf(stderr, "the in-memory backend is not built in\n");
+    return 1;
+  }
+  for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+    if (tests[i].run()) {
+      fprintf(stderr, "%s: failed\n", tests[i].name);
+      failed = 1;
+    } else {
+      printf("%s: ok\n", tests[i].name);
+    }
+  }
+  return failed;
+}
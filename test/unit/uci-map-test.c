@@ -0,0 +1,321 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <uci.h>
+#include <unistd.h>
+#include "arena.h"
+#include "uci/methods.h"
+#include "uci/uci-emit.h"
+#include "uci/uci-map.h"
+#include "util.h"
+#include "vector.h"
+
+#define TEST_PACKAGE "restconf_map_test"
+
+/**
+ * A change in the form of the uci command line, e.g. set with
+ * package.section.option=value, add is given the type of the section
+ */
+struct UciChange {
+  const char *command;
+  const char *path;
+};
+
+/**
+ * A configuration file and the deltas saved on top of it, first to the
+ * running delta directory and then to the one of the request
+ */
+struct UciMapCase {
+  const char *name;
+  const char *config;
+  struct UciChange running[16];
+  struct UciChange request[16];
+};
+
+static const struct UciMapCase cases[] = {
+    {"anonymous sections",
+     "package " TEST_PACKAGE "\n"
+     "\n"
+     "config room\n"
+     "\toption number 'A101'\n"
+     "\toption seats '40'\n"
+     "\n"
+     "config room\n"
+     "\toption number 'B202'\n"
+     "\tlist tags 'lab'\n"
+     "\tlist tags 'quiet'\n"
+     "\n"
+     "config settings 'main'\n"
+     "\toption campus \"North \\\"Gate\\\"\"\n"
+     "\toption motto 'it'\\''s'\n"
+     "\n"
+     "config room\n"
+     "\toption number 'C303'\n"
+     "\toption note 'caf\xc3\xa9'\n",
+     {{"set", TEST_PACKAGE ".@room[0].seats=50"},
+      {"add_list", TEST_PACKAGE ".@room[1].tags=projector"},
+      {"del_list", TEST_PACKAGE ".@room[1].tags=lab"},
+      {"add", "room"},
+      {"set", TEST_PACKAGE ".@room[-1].number=D404"},
+      {"rename", TEST_PACKAGE ".@room[2]=corner"},
+      {"reorder", TEST_PACKAGE ".main=0"},
+      {NULL, NULL}},
+     {{"set", TEST_PACKAGE ".main.campus=South"},
+      {"delete", TEST_PACKAGE ".@room[0].seats"},
+      {"delete", TEST_PACKAGE ".@room[1]"},
+      {"add", "room"},
+      {"add_list", TEST_PACKAGE ".@room[-1].tags=new"},
+      {"set", TEST_PACKAGE ".extra=room"},
+      {"set", TEST_PACKAGE ".extra.number=E505"},
+      {"rename", TEST_PACKAGE ".corner.number=code"},
+      {NULL, NULL}}},
+    {"named sections",
+     "config course 'course'\n"
+     "\toption name 'Networks'\n"
+     "\tlist instructors 'Smith'\n"
+     "\n"
+     "config student 'doe'\n"
+     "\toption lastname 'doe'\n"
+     "\toption age '21'\n",
+     {{"delete", TEST_PACKAGE ".doe"},
+      {"set", TEST_PACKAGE ".doe=student"},
+      {"set", TEST_PACKAGE ".doe.age=22"},
+      {"set", TEST_PACKAGE ".course.instructors=Jones"},
+      {NULL, NULL}},
+     {{"add_list", TEST_PACKAGE ".course.instructors=Brown"},
+      {"reorder", TEST_PACKAGE ".doe=0"},
+      {NULL, NULL}}},
+    {"empty file",
+     "",
+     {{"add", "room"},
+      {"set", TEST_PACKAGE ".@room[0].number=A101"},
+      {"add", "room"},
+      {NULL, NULL}},
+     {{"add", "room"},
+      {"set", TEST_PACKAGE ".@room[-1].number=B202"},
+      {"delete", TEST_PACKAGE ".@room[1]"},
+      {NULL, NULL}}}};
+
+/**
+ * @brief create a directory if it does not exist
+ * @param path the directory
+ * @return 0 if success else 1
+ */
+static int make_dir(const char *path) {
+  return mkdir(path, 0700) && errno != EEXIST;
+}
+
+/**
+ * @brief write the configuration of a case and drop earlier deltas
+ * @param test the case
+ * @return 0 if success else 1
+ */
+static int write_config(const struct UciMapCase *test) {
+  char path[512];
+  FILE *file = NULL;
+
+  if (make_dir(RESTCONF_UCI_CONFDIR) || make_dir(RESTCONF_UCI_SAVEDIR)) {
+    return 1;
+  }
+  snprintf(path, sizeof(path), "%s/%s", RESTCONF_UCI_SAVEDIR, TEST_PACKAGE);
+  if (unlink(path) && errno != ENOENT) {
+    return 1;
+  }
+  uci_request_savedir_release();
+  snprintf(path, sizeof(path), "%s/%s", RESTCONF_UCI_CONFDIR, TEST_PACKAGE);
+  if (!(file = fopen(path, "w"))) {
+    return 1;
+  }
+  fputs(test->config, file);
+  return fclose(file) != 0;
+}
+
+/**
+ * @brief allocate a context that reads the test directories
+ * The deltas are read in the order the mapped reader applies them.
+ * @param request save to the delta directory of the request instead of the
+ * running one
+ * @return the context or NULL
+ */
+static struct uci_context *test_context(int request) {
+  struct uci_context *ctx = uci_alloc_context();
+  if (!ctx) {
+    return NULL;
+  }
+  if (uci_set_confdir(ctx, RESTCONF_UCI_CONFDIR) != UCI_OK ||
+      uci_set_savedir(ctx, RESTCONF_UCI_SAVEDIR) != UCI_OK ||
+      (request && uci_set_savedir(ctx, uci_request_savedir()) != UCI_OK)) {
+    uci_free_context(ctx);
+    return NULL;
+  }
+  return ctx;
+}
+
+/**
+ * @brief make a change through libuci
+ * @param ctx the context
+ * @param change the change
+ * @return 0 if success else 1
+ */
+static int apply_change(struct uci_context *ctx,
+                        const struct UciChange *change) {
+  struct uci_ptr ptr;
+  const char *command = change->command;
+  int add = strcmp(command, "add") == 0;
+  char *path = str_dup(add ? TEST_PACKAGE : change->path);
+
+  if (!path || uci_lookup_ptr(ctx, &ptr, path, true) != UCI_OK) {
+    return 1;
+  }
+  if (add) {
+    struct uci_section *added = NULL;
+    return uci_add_section(ctx, ptr.p, change->path, &added) != UCI_OK;
+  } else if (strcmp(command, "set") == 0) {
+    return uci_set(ctx, &ptr) != UCI_OK;
+  } else if (strcmp(command, "add_list") == 0) {
+    return uci_add_list(ctx, &ptr) != UCI_OK;
+  } else if (strcmp(command, "del_list") == 0) {
+    return uci_del_list(ctx, &ptr) != UCI_OK;
+  } else if (strcmp(command, "delete") == 0) {
+    return uci_delete(ctx, &ptr) != UCI_OK;
+  } else if (strcmp(command, "rename") == 0) {
+    return uci_rename(ctx, &ptr) != UCI_OK;
+  } else if (strcmp(command, "reorder") == 0) {
+    return uci_reorder_section(ctx, ptr.s, atoi(ptr.value)) != UCI_OK;
+  }
+  return 1;
+}
+
+/**
+ * @brief make changes through libuci and save them as deltas
+ * @param changes the changes, terminated by one without command
+ * @param request save to the delta directory of the request
+ * @return 0 if success else 1
+ */
+static int save_changes(const struct UciChange *changes, int request) {
+  struct uci_context *ctx = test_context(request);
+  struct uci_ptr ptr;
+  char *package = str_dup(TEST_PACKAGE);
+  int failed = !ctx || !package;
+
+  for (; !failed && changes->command; changes++) {
+    if ((failed = apply_change(ctx, changes))) {
+      fprintf(stderr, "cannot %s %s\n", changes->command, changes->path);
+    }
+  }
+  failed = failed || uci_lookup_ptr(ctx, &ptr, package, true) != UCI_OK ||
+           uci_save(ctx, ptr.p) != UCI_OK;
+  if (ctx) {
+    uci_free_context(ctx);
+  }
+  return failed;
+}
+
+/**
+ * @brief write every section of a package index the way GET writes it
+ * Each section is an object keyed by its name and type, so a name that
+ * differs is reported as well.
+ * @param map the package index
+ * @return the output in a buffer that is freed by the caller or NULL
+ */
+static char *render(const struct UciMap *map) {
+  struct UciEmit emit;
+  char *output = NULL;
+  size_t size = 0;
+
+  memset(&emit, 0, sizeof(emit));
+  if (!(emit.out = open_memstream(&output, &size))) {
+    return NULL;
+  }
+  emit.entry = -1;
+  emit.map = *map;
+  uci_emit_open(&emit, "", '{');
+  for (size_t i = 0; i < vector_size(map->sections); i++) {
+    const struct UciMapSection *section = &map->sections[i];
+    char *name = uci_slice_dup(section->name);
+    char *type = uci_slice_dup(section->type);
+    char key[256];
+
+    snprintf(key, sizeof(key), "\"%s %s%s\": ", name, type,
+             section->anonymous ? " anonymous" : "");
+    uci_emit_open(&emit, str_dup(key), '{');
+    for (size_t j = 0; j < vector_size(section->options); j++) {
+      char *option = uci_slice_dup(section->options[j].name);
+      snprintf(key, sizeof(key), "\"%s\": ", option);
+      if (section->options[j].list) {
+        uci_emit_leaf_list(&emit, str_dup(key), section, option, 0);
+      } else {
+        uci_emit_leaf(&emit, str_dup(key), section, option, 0);
+      }
+    }
+    uci_emit_close(&emit, UCI_EMIT_KEEP_EMPTY);
+  }
+  uci_emit_close(&emit, UCI_EMIT_KEEP_EMPTY);
+  fclose(emit.out);
+  return output;
+}
+
+/**
+ * @brief compare the mapped reader with libuci on one case
+ * @param test the case
+ * @return 0 if both read the same else 1
+ */
+static int run_case(const struct UciMapCase *test) {
+  struct UciMap mapped = INIT_UCI_MAP();
+  struct UciMap loaded = INIT_UCI_MAP();
+  struct uci_context *ctx = NULL;
+  struct uci_ptr ptr;
+  char *package = str_dup(TEST_PACKAGE);
+  char *expected = NULL;
+  char *actual = NULL;
+  int failed = 1;
+
+  if (write_config(test) || save_changes(test->running, 0) ||
+      save_changes(test->request, 1)) {
+    fprintf(stderr, "%s: cannot set up the package\n", test->name);
+    return 1;
+  }
+  if (uci_map_open(&mapped, TEST_PACKAGE)) {
+    fprintf(stderr, "%s: the mapped reader left the package to libuci\n",
+            test->name);
+    return 1;
+  }
+  if (!package || !(ctx = test_context(1)) ||
+      uci_lookup_ptr(ctx, &ptr, package, true) != UCI_OK || !ptr.p) {
+    fprintf(stderr, "%s: libuci cannot load the package\n", test->name);
+    goto done;
+  }
+  uci_map_from_package(&loaded, ptr.p);
+  if (!(expected = render(&loaded)) || !(actual = render(&mapped))) {
+    goto done;
+  }
+  if ((failed = strcmp(expected, actual) != 0)) {
+    fprintf(stderr, "%s: libuci reads\n%s\nthe mapped reader reads\n%s\n",
+            test->name, expected, actual);
+  }
+done:
+  if (ctx) {
+    uci_free_context(ctx);
+  }
+  free(expected);
+  free(actual);
+  uci_map_free(&mapped);
+  uci_map_free(&loaded);
+  return failed;
+}
+
+int main(void) {
+  int failed = 0;
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    if (run_case(&cases[i])) {
+      failed = 1;
+    } else {
+      printf("%s: ok\n", cases[i].name);
+    }
+  }
+  uci_request_savedir_release();
+  arena_release(request_arena());
+  return failed;
+}
@@ -1,6 +1,9 @@
 import argparse
 import json
 import os
+import re
+import sys
+from decimal import Decimal
 
 import xmltodict
 from mako.lookup import TemplateLookup
@@ -9,8 +12,13 @@ from mako.template import Template
 dirname = os.path.dirname(os.path.realpath(__file__))
 mylookup = TemplateLookup(directories=[os.path.join(dirname, "./template")])
 header_file = Template(filename=os.path.join(dirname, "./template/yang.h.templ"), lookup=mylookup)
+emit_file = Template(filename=os.path.join(dirname, "./template/yang-emit.c.templ"), lookup=mylookup)
+validate_file = Template(filename=os.path.join(dirname, "./template/yang-validate.c.templ"), lookup=mylookup)
+constraint_file = Template(filename=os.path.join(dirname, "./template/yang-constraint.c.templ"), lookup=mylookup)
+leafref_file = Template(filename=os.path.join(dirname, "./template/yang-leafref.c.templ"), lookup=mylookup)
 
 types = {}
+identities = {}
 ALLOWED_TYPES = {
     "string": "STRING",
     "int8": "INT_8",
@@ -23,7 +31,47 @@ ALLOWED_TYPES = {
     "uint64": "UINT_64",
     "binary": "BINARY",
     "boolean": "BOOLEAN",
-    "decimal64": "DECIMAL_64"
+    "decimal64": "DECIMAL_64",
+    "enumeration": "ENUMERATION",
+    "bits": "BITS",
+    "identityref": "IDENTITY_REF",
+    "leafref": "LEAF_REF",
+    "union": "UNION"
+}
+COMPOUND_TYPES = ["enumeration", "bits", "identityref", "union"]
+
+XPATH_TOKEN = re.compile(r"""\s*(?:(?P<number>\d+(?:\.\d+)?)|(?P<literal>'[^']*'|"[^"]*")|"""
+                         r"""(?P<operator>!=|<=|>=|\.\.|[=<>()+\-/,.\[\]*|@$])|"""
+                         r"""(?P<name>[A-Za-z_][\w.\-]*(?::[A-Za-z_][\w.\-]*)?))""")
+XPATH_OPERATORS = [
+    {"or": "XPATH_OR"},
+    {"and": "XPATH_AND"},
+    {"=": "XPATH_EQ", "!=": "XPATH_NE"},
+    {"<": "XPATH_LT", "<=": "XPATH_LE", ">": "XPATH_GT", ">=": "XPATH_GE"},
+    {"+": "XPATH_ADD", "-": "XPATH_SUB"}
+]
+XPATH_FUNCTIONS = {
+    "true": ("XPATH_TRUE", 0),
+    "false": ("XPATH_FALSE", 0),
+    "not": ("XPATH_NOT", 1),
+    "count": ("XPATH_COUNT", 1),
+    "string-length": ("XPATH_STRING_LENGTH", 1),
+    "contains": ("XPATH_CONTAINS", 2),
+    "starts-with": ("XPATH_STARTS_WITH", 2)
+}
+XPATH_MAX_STACK = 16
+
+NUMBER_TYPES = ["INT_8", "INT_16", "INT_32", "UINT_8", "UINT_16", "UINT_32"]
+STRING_TYPES = ["STRING", "INT_64", "UINT_64"]
+INTEGER_BOUNDS = {
+    "INT_8": (-2 ** 7, 2 ** 7 - 1),
+    "INT_16": (-2 ** 15, 2 ** 15 - 1),
+    "INT_32": (-2 ** 31, 2 ** 31 - 1),
+    "INT_64": (-2 ** 63, 2 ** 63 - 1),
+    "UINT_8": (0, 2 ** 8 - 1),
+    "UINT_16": (0, 2 ** 16 - 1),
+    "UINT_32": (0, 2 ** 32 - 1),
+    "UINT_64": (0, 2 ** 64 - 1)
 }
 
 
@@ -61,6 +109,12 @@ def convert_yin_to_json(data):
     return json.loads(json.dumps(val))
 
 
+def as_list(value):
+    if value is None:
+        return []
+    return value if isinstance(value, list) else [value]
+
+
 def range_allowed(name):
     return name in ["int8", "int16", "int32", "int64", "uint8", "uint16", "uint32", "uint64"]
 
@@ -88,6 +142,46 @@ def extract_uci_statements(generated, key, value, imported):
         generated["section"] = value["@name"]
     if key == imported.openwrt_prefix + ":leaf-as-name":
         generated["leaf-as-name"] = value["@name"]
+    if key == imported.openwrt_prefix + ":key-hash-name":
+        generated["key-hash-name"] = value["@name"]
+
+
+def compound_type(value, imported):
+    converted = {
+        "leaf-type": value["@name"]
+    }
+    if value["@name"] == "enumeration":
+        converted["enum"] = [item["@name"] for item in as_list(value.get("enum"))]
+    elif value["@name"] == "bits":
+        converted["bit"] = [item["@name"] for item in as_list(value.get("bit"))]
+    elif value["@name"] == "identityref":
+        converted["base"] = value["base"]["@name"].split(":")[-1]
+    elif value["@name"] == "union":
+        converted["types"] = []
+        for member in as_list(value.get("type")):
+            member_type = {}
+            extract_type_statements(member_type, "type", member, imported)
+            converted["types"].append(member_type["leaf-type"])
+    return converted
+
+
+def decimal_type(value):
+    """Converts a decimal64 type with its fraction-digits and range"""
+    converted = {
+        "leaf-type": "decimal64"
+    }
+    if "fraction-digits" in value:
+        converted["fraction-digits"] = int(value["fraction-digits"]["@value"])
+    if "range" in value:
+        range_split = value["range"]["@value"].split("..", 1)
+        converted["from"] = range_split[0]
+        converted["to"] = range_split[1] if len(range_split) > 1 else range_split[0]
+    return converted
+
+
+def handle_identity(identity):
+    for item in as_list(identity):
+        identities[item["@name"]] = [base["@name"].split(":")[-1] for base in as_list(item.get("base"))]
 
 
 def extract_type_statements(generated, key, value, imported):
@@ -103,6 +197,8 @@ def extract_type_statements(generated, key, value, imported):
         })
     elif type_name not in ALLOWED_TYPES and type_name not in types:
         raise Exception("Unsupported type \"{}\" used".format(type_name))
+    if type_name == "decimal64":
+        type_name = decimal_type(value)
     if type_name == "string" and "pattern" in value:
         type_name = {
             "leaf-type": type_name,
@@ -115,10 +211,17 @@ def extract_type_statements(generated, key, value, imported):
             "from": range_split[0],
             "to": range_split[1]
         }
+    if type_name in COMPOUND_TYPES:
+        type_name = compound_type(value, imported)
+    if type_name == "leafref":
+        type_name = {
+            "leaf-type": type_name,
+            "path": value["path"]["@value"]
+        }
     generated["leaf-type"] = type_name
 
 
-def handle_typedef(typedefs):
+def handle_typedef(typedefs, imported):
     if isinstance(typedefs, dict):
         import_type = typedefs["type"]["@name"]
         if import_type not in ALLOWED_TYPES and import_type not in types:
@@ -126,6 +229,12 @@ def handle_typedef(typedefs):
         converted = {
             "leaf-type": typedefs["type"]["@name"]
         }
+        if import_type in COMPOUND_TYPES:
+            converted = compound_type(typedefs["type"], imported)
+        if import_type == "leafref":
+            converted["path"] = typedefs["type"]["path"]["@value"]
+        if import_type == "decimal64":
+            converted = decimal_type(typedefs["type"])
         if converted["leaf-type"] == "string" and "pattern" in typedefs["type"]:
             converted["pattern"] = "^" + typedefs["type"]["pattern"]["@value"] + "$"
         if range_allowed(converted["leaf-type"]) and "range" in typedefs["type"]:
@@ -135,7 +244,7 @@ def handle_typedef(typedefs):
         types[typedefs["@name"]] = converted
     elif isinstance(typedefs, list):
         for item in typedefs:
-            handle_typedef(item)
+            handle_typedef(item, imported)
 
 
 def process_node(generated, key, value, imported):
@@ -160,7 +269,9 @@ def convert(level, imported, object_type=None):
         if "import" in changed_level:
             handle_import(changed_level["import"], imported)
         if "typedef" in changed_level:
-            handle_typedef(changed_level["typedef"])
+            handle_typedef(changed_level["typedef"], imported)
+        if "identity" in changed_level:
+            handle_identity(changed_level["identity"])
     if object_type is not None:
         generated["type"] = object_type
     generated["map"] = {}
@@ -176,6 +287,10 @@ def convert(level, imported, object_type=None):
         if key == "unique":
             to_be_split = value["@value"]
             generated["unique"] = to_be_split.split()
+        if key == "must":
+            generated["must"] = [item["@condition"] for item in as_list(value)]
+        if key == "when":
+            generated["when"] = value["@condition"]
         if key in ["container", "leaf", "leaf-list", "list"]:
             process_node(generated, key, value, imported)
     return generated
@@ -189,6 +304,8 @@ def process_imported_types(args, imported):
             if "typedef" not in mod:
                 raise Exception("Type is not declared in module \"{}\"".format(mod))
             typedef = mod["typedef"]
+            if "identity" in mod:
+                handle_identity(mod["identity"])
             if isinstance(typedef, list):
                 for item in typedef:
                     for val in value:
@@ -199,6 +316,8 @@ def process_imported_types(args, imported):
                             converted = {
                                 "leaf-type": import_type
                             }
+                            if import_type in COMPOUND_TYPES:
+                                converted = compound_type(item["type"], imported)
                             if converted["leaf-type"] == "string" and "pattern" in item["type"]:
                                 converted["pattern"] = []
                                 if isinstance(item["type"]["pattern"], list):
@@ -213,6 +332,601 @@ def process_imported_types(args, imported):
                             types[val["type_name"]] = converted
 
 
+def base_type(leaf_type):
+    name = leaf_type["leaf-type"] if isinstance(leaf_type, dict) else leaf_type
+    if name in ALLOWED_TYPES:
+        return ALLOWED_TYPES[name]
+    if name in types:
+        return base_type(types[name]["leaf-type"])
+    return "NONE"
+
+
+def c_string(value):
+    escaped = ""
+    for byte in value.encode("utf-8"):
+        char = chr(byte)
+        if char in "\"\\":
+            escaped += "\\" + char
+        elif 32 <= byte < 127:
+            escaped += char
+        else:
+            escaped += "\\%03o" % byte
+    return "\"" + escaped + "\""
+
+
+def c_identifier(prefix, parts):
+    return prefix + "_".join(re.sub("[^A-Za-z0-9]", "_", part) for part in parts)
+
+
+def c_integer(value):
+    if value == -2 ** 63:
+        return "INT64_MIN"
+    if value == 2 ** 63 - 1:
+        return "INT64_MAX"
+    if value == 2 ** 64 - 1:
+        return "UINT64_MAX"
+    return str(value)
+
+
+def emit_member(key, child, emitters, path, module_name):
+    member = {
+        "kind": child["type"],
+        "key": c_string(json.dumps(key) + ": ")
+    }
+    if child["type"] in ["leaf", "leaf-list"]:
+        if "option" not in child or "leaf-type" not in child:
+            return None
+        leaf_type = base_type(child["leaf-type"])
+        # the generic walk formats leaves of unknown type as string
+        if leaf_type == "NONE" and child["type"] == "leaf":
+            leaf_type = "STRING"
+        if leaf_type not in NUMBER_TYPES and leaf_type not in STRING_TYPES:
+            return None
+        member["option"] = c_string(child["option"])
+        member["number"] = 1 if leaf_type in NUMBER_TYPES else 0
+        return member
+    function = collect_emitters(module_name, child, path + [key], emitters)
+    if function is None:
+        return None
+    member["function"] = function
+    return member
+
+
+def collect_emitters(module_name, node, path, emitters):
+    """Collects the emitters of a container or list and the nodes below it
+
+    The emitters are appended in the order they have to be defined. None is
+    returned if the node has to be read by the generic walk.
+    """
+    if node["type"] == "list" and "section" not in node:
+        return None
+    if node["type"] == "container" and "section" in node and "section-name" not in node:
+        return None
+    members = []
+    supported = True
+    for key, child in node["map"].items():
+        member = emit_member(key, child, emitters, path, module_name)
+        if member is None:
+            supported = False
+        members.append(member)
+    if not supported:
+        return None
+    function = c_identifier("emit_", [module_name] + path)
+    emitters.append({
+        "function": function,
+        "module": module_name,
+        "path": "/".join(path),
+        "type": node["type"],
+        "section-name": c_string(node["section-name"]) if "section-name" in node else None,
+        "section": c_string(node["section"]) if "section" in node else None,
+        "members": members
+    })
+    return function
+
+
+def module_emitters(modules):
+    emitters = []
+    for name, module in modules:
+        if "package" not in module:
+            continue
+        for key, node in module["map"].items():
+            if node["type"] in ["container", "list"]:
+                collect_emitters(name, node, [key], emitters)
+    return emitters
+
+
+def type_constraints(leaf_type):
+    """Resolves a leaf type through its typedefs
+
+    Returns the base type, the range of the most derived type that has one
+    and the patterns of all types, which all have to match.
+    """
+    restriction = leaf_type if isinstance(leaf_type, dict) else {}
+    name = leaf_type["leaf-type"] if isinstance(leaf_type, dict) else leaf_type
+    if name in ALLOWED_TYPES:
+        base, value_range, patterns = ALLOWED_TYPES[name], None, []
+    elif name in types:
+        base, value_range, patterns = type_constraints(types[name])
+    else:
+        return "NONE", None, []
+    if "pattern" in restriction:
+        pattern = restriction["pattern"]
+        patterns = patterns + (pattern if isinstance(pattern, list) else [pattern])
+    if "from" in restriction:
+        value_range = restriction["from"] + ".." + restriction["to"]
+    return base, value_range, patterns
+
+
+def range_intervals(base, value_range):
+    lowest, highest = INTEGER_BOUNDS[base]
+    if value_range is None:
+        return [(lowest, highest)]
+    intervals = []
+    for part in value_range.split("|"):
+        bounds = [bound.strip() for bound in part.split("..", 1)]
+        if len(bounds) == 1:
+            bounds.append(bounds[0])
+        low = lowest if bounds[0] == "min" else max(lowest, int(bounds[0]))
+        high = highest if bounds[1] == "max" else min(highest, int(bounds[1]))
+        intervals.append((low, high))
+    return intervals
+
+
+def fraction_digits(leaf_type):
+    """Returns the fraction-digits of a decimal64 type through its typedefs"""
+    while True:
+        if isinstance(leaf_type, dict) and "fraction-digits" in leaf_type:
+            return leaf_type["fraction-digits"]
+        name = leaf_type["leaf-type"] if isinstance(leaf_type, dict) else leaf_type
+        if name not in types:
+            raise Exception("decimal64 without fraction-digits")
+        leaf_type = types[name]
+
+
+def decimal_intervals(value_range, digits):
+    """Returns the intervals of a decimal64 range scaled by its fraction-digits"""
+    lowest, highest = INTEGER_BOUNDS["INT_64"]
+    if value_range is None:
+        return [(lowest, highest)]
+    intervals = []
+    for part in value_range.split("|"):
+        bounds = [bound.strip() for bound in part.split("..", 1)]
+        if len(bounds) == 1:
+            bounds.append(bounds[0])
+        scaled = [int(Decimal(bound).scaleb(digits)) if bound not in ["min", "max"] else bound for bound in bounds]
+        low = lowest if scaled[0] == "min" else max(lowest, scaled[0])
+        high = highest if scaled[1] == "max" else min(highest, scaled[1])
+        intervals.append((low, high))
+    return intervals
+
+
+def resolve_type(leaf_type):
+    """Follows the typedefs of a type to the definition of its built-in type"""
+    name = leaf_type["leaf-type"] if isinstance(leaf_type, dict) else leaf_type
+    while name not in ALLOWED_TYPES and name in types:
+        leaf_type = types[name]
+        name = leaf_type["leaf-type"]
+    return leaf_type
+
+
+def derived_identities(base):
+    derived = []
+    for name, bases in identities.items():
+        if base in bases:
+            derived.append(name)
+            derived.extend(item for item in derived_identities(name) if item not in derived)
+    return derived
+
+
+def fnv1a(seed, name):
+    hashed = seed
+    for byte in name.encode("utf-8"):
+        hashed = ((hashed ^ byte) * 16777619) & 0xffffffff
+    return hashed
+
+
+def perfect_hash(names):
+    """Finds a seed and a power of two table size without collisions
+
+    A name is then found by hashing it and comparing it to a single slot.
+    """
+    size = 1
+    while size < 2 * len(names):
+        size *= 2
+    while True:
+        for seed in range(2166136261, 2166136261 + 256):
+            slots = [None] * size
+            for name in names:
+                slot = fnv1a(seed, name) % size
+                if slots[slot] is not None:
+                    break
+                slots[slot] = name
+            else:
+                return seed, slots
+        size *= 2
+
+
+def name_set(names, tables):
+    names = sorted(set(names))
+    for index, existing in enumerate(tables["name_sets"]):
+        if existing["names"] == names:
+            return "names_{}".format(index)
+    seed, slots = perfect_hash(names)
+    tables["name_sets"].append({
+        "names": names,
+        "seed": seed,
+        "slots": [c_string(slot) if slot is not None else "NULL" for slot in slots]
+    })
+    return "names_{}".format(len(tables["name_sets"]) - 1)
+
+
+def validator_body(leaf_type, tables):
+    """Returns the C expression that is 1 if a value is invalid
+
+    None is returned for types that are verified by yang_verify_value_type.
+    """
+    definition = resolve_type(leaf_type)
+    if isinstance(definition, dict) and definition["leaf-type"] in COMPOUND_TYPES:
+        return compound_body(definition, tables)
+    base, value_range, type_patterns = type_constraints(leaf_type)
+    if base in INTEGER_BOUNDS:
+        check = "yang_verify_unsigned" if base == "UINT_64" else "yang_verify_integer"
+        return " &&\n         ".join(
+            "{}(value, {}, {})".format(check, c_integer(low), c_integer(high))
+            for low, high in range_intervals(base, value_range))
+    if base == "BOOLEAN":
+        return "yang_verify_boolean(value)"
+    if base == "DECIMAL_64":
+        digits = fraction_digits(leaf_type)
+        return " &&\n         ".join(
+            "yang_verify_decimal64(value, {}, {}, {})".format(digits, c_integer(low), c_integer(high))
+            for low, high in decimal_intervals(value_range, digits))
+    if base == "STRING":
+        checks = []
+        patterns = tables["patterns"]
+        for pattern in type_patterns:
+            if pattern not in patterns:
+                patterns.append(pattern)
+            checks.append("yang_verify_pattern(&pattern_{}, value)".format(patterns.index(pattern)))
+        return " ||\n         ".join(checks) if checks else "0"
+    return None
+
+
+def compound_body(definition, tables):
+    if definition["leaf-type"] == "enumeration":
+        return "yang_verify_enum(&{}, value)".format(name_set(definition["enum"], tables))
+    if definition["leaf-type"] == "bits":
+        return "yang_verify_bits(&{}, value)".format(name_set(definition["bit"], tables))
+    if definition["leaf-type"] == "identityref":
+        return "yang_verify_identity(&{}, value)".format(
+            name_set(derived_identities(definition["base"]), tables))
+    # the members are tried in the order of the union
+    members = [validator_body(member, tables) for member in definition["types"]]
+    if not members or None in members:
+        return None
+    return " &&\n         ".join("({})".format(member) for member in members)
+
+
+def collect_validators(module_name, node, path, validators, tables):
+    """Compiles the type of every leaf below a node into a validator
+
+    The index of the validator is stored in the leaf, so the verification
+    can call it directly.
+    """
+    for key, child in node["map"].items():
+        if child["type"] in ["leaf", "leaf-list"]:
+            body = validator_body(child["leaf-type"], tables) if "leaf-type" in child else None
+            if body is None:
+                continue
+            child["verify"] = len(validators)
+            validators.append({
+                "function": c_identifier("verify_", [module_name] + path + [key]),
+                "body": body
+            })
+        else:
+            collect_validators(module_name, child, path + [key], validators, tables)
+
+
+def module_validators(modules):
+    validators = []
+    tables = {
+        "patterns": [],
+        "name_sets": []
+    }
+    for name, module in modules:
+        collect_validators(name, module, [], validators, tables)
+    return validators, tables
+
+
+def schema_path(ancestors, steps):
+    """Resolves the steps of a path to the nodes from the module to its target
+
+    The number of nodes of the context the path never left is returned as
+    well, it is 0 for absolute paths.
+    """
+    nodes = list(ancestors)
+    kept = len(nodes)
+    if steps and steps[0] == "":
+        nodes = nodes[:1]
+        kept = 0
+        steps = steps[1:]
+    for step in steps:
+        if step == ".":
+            continue
+        if step == ".." and len(nodes) > 1:
+            nodes.pop()
+            kept = min(kept, len(nodes))
+        elif step in nodes[-1].get("map", {}):
+            nodes.append(nodes[-1]["map"][step])
+        else:
+            return None, 0
+    return nodes, kept
+
+
+def uci_section(nodes):
+    """Returns the UCI section of the last node and the index of the node
+    that defines it, or None if the node is not stored in a section"""
+    target = {}
+    index = None
+    for position, node in enumerate(nodes):
+        if "package" in node:
+            target = {"package": node["package"]}
+            index = None
+        if "section-name" in node:
+            target.pop("section", None)
+            target["section-name"] = node["section-name"]
+            index = position
+        elif node.get("type") == "list" and "section" in node:
+            target.pop("section-name", None)
+            target["section"] = node["section"]
+            index = position
+    if len(target) != 2:
+        return None, None
+    return target, index
+
+
+def leafref_target(ancestors, path):
+    """Resolves the path of a leafref to the UCI options of the referenced leaf
+
+    The path is resolved against the nodes from the module to the leaf.
+    Predicates are dropped, so every value of the referenced leaf is allowed.
+    """
+    steps = [step.strip().split(":")[-1] for step in re.sub(r"\[.*?\]", "", path).split("/")]
+    nodes, kept = schema_path(ancestors, steps)
+    if nodes is None:
+        raise Exception("Leafref path \"{}\" does not exist".format(path))
+    leaf = nodes[-1]
+    target, index = uci_section(nodes)
+    if leaf.get("type") not in ["leaf", "leaf-list"] or "option" not in leaf or target is None:
+        raise Exception("Leafref path \"{}\" does not point to a UCI option".format(path))
+    target["option"] = leaf["option"]
+    return target
+
+
+def leafref_source(nodes):
+    """Returns the UCI option a leafref leaf is stored in"""
+    source, index = uci_section(nodes)
+    if "option" not in nodes[-1] or source is None:
+        raise Exception("Leafref \"{}\" is not stored in a UCI option".format(nodes[-1]))
+    source["option"] = nodes[-1]["option"]
+    return source
+
+
+def resolve_leafrefs(ancestors, leafrefs):
+    """Collects the UCI options of every leafref below a node and of the leaf
+    it references"""
+    for child in ancestors[-1]["map"].values():
+        if child["type"] in ["leaf", "leaf-list"]:
+            definition = resolve_type(child["leaf-type"]) if "leaf-type" in child else None
+            if isinstance(definition, dict) and definition["leaf-type"] == "leafref":
+                leafrefs.append({
+                    "source": leafref_source(ancestors + [child]),
+                    "target": leafref_target(ancestors + [child], definition["path"])
+                })
+        else:
+            resolve_leafrefs(ancestors + [child], leafrefs)
+
+
+class XPathUnsupported(Exception):
+    pass
+
+
+class XPathCompiler:
+    """Compiles the XPath subset of must and when into stack machine code
+
+    Paths have to point to leaves or leaf-lists with a UCI option. A path that
+    stays in the section of the constrained node is read from that section,
+    any other path reads the option in all sections it is stored in.
+    """
+
+    def __init__(self, expression, ancestors, section_index, tables):
+        self.tokens = []
+        self.position = 0
+        self.ancestors = ancestors
+        self.section_index = section_index
+        self.tables = tables
+        self.code = []
+        self.depth = 0
+        position = 0
+        while expression[position:].strip():
+            match = XPATH_TOKEN.match(expression, position)
+            if not match:
+                raise XPathUnsupported(expression[position:])
+            self.tokens.append((match.lastgroup, match.group(match.lastgroup)))
+            position = match.end()
+
+    def compile(self):
+        self.binary(0)
+        if self.position != len(self.tokens):
+            raise XPathUnsupported(self.peek())
+        return self.code
+
+    def peek(self, offset=0):
+        if self.position + offset < len(self.tokens):
+            return self.tokens[self.position + offset][1]
+        return None
+
+    def take(self, expected=None):
+        if self.position >= len(self.tokens) or (expected and self.peek() != expected):
+            raise XPathUnsupported(expected or "end of expression")
+        self.position += 1
+        return self.tokens[self.position - 1]
+
+    def emit(self, op, arg=0, pushed=1, popped=0):
+        self.code.append((op, arg))
+        self.depth += pushed - popped
+        if self.depth > XPATH_MAX_STACK:
+            raise XPathUnsupported("expression too deep")
+
+    def constant(self, table, value):
+        if value not in self.tables[table]:
+            self.tables[table].append(value)
+        return self.tables[table].index(value)
+
+    def binary(self, level):
+        if level == len(XPATH_OPERATORS):
+            return self.unary()
+        self.binary(level + 1)
+        while self.peek() in XPATH_OPERATORS[level]:
+            op = XPATH_OPERATORS[level][self.take()[1]]
+            self.binary(level + 1)
+            self.emit(op, popped=1, pushed=0)
+
+    def unary(self):
+        if self.peek() == "-":
+            self.take()
+            self.unary()
+            self.emit("XPATH_NEG", pushed=0)
+            return
+        kind, value = self.tokens[self.position] if self.position < len(self.tokens) else (None, None)
+        if kind == "number":
+            self.take()
+            self.emit("XPATH_NUMBER", self.constant("numbers", float(value)))
+        elif kind == "literal":
+            self.take()
+            self.emit("XPATH_STRING", self.constant("strings", value[1:-1]))
+        elif value == "(":
+            self.take()
+            self.binary(0)
+            self.take(")")
+        elif kind == "name" and self.peek(1) == "(" and value != "current":
+            self.function(value)
+        else:
+            self.path()
+
+    def function(self, name):
+        if name not in XPATH_FUNCTIONS:
+            raise XPathUnsupported(name + "()")
+        op, arguments = XPATH_FUNCTIONS[name]
+        self.take()
+        self.take("(")
+        for argument in range(arguments):
+            if argument:
+                self.take(",")
+            self.binary(0)
+        self.take(")")
+        if op == "XPATH_COUNT" and self.code[-1][0] != "XPATH_PATH":
+            raise XPathUnsupported("count() of a value that is not a path")
+        self.emit(op, pushed=1, popped=arguments)
+
+    def path(self):
+        steps = []
+        if self.peek() == "current":
+            self.take()
+            self.take("(")
+            self.take(")")
+            steps.append(".")
+            if self.peek() == "/":
+                self.take()
+        elif self.peek() == "/":
+            self.take()
+            steps.append("")
+        while True:
+            kind, value = self.take()
+            if kind != "name" and value not in [".", ".."]:
+                raise XPathUnsupported(value)
+            steps.append(value.split(":")[-1])
+            if self.peek() != "/":
+                break
+            self.take()
+        nodes, kept = schema_path(self.ancestors, steps)
+        if nodes is None:
+            raise XPathUnsupported("/".join(steps))
+        leaf = nodes[-1]
+        target, index = uci_section(nodes)
+        if leaf.get("type") not in ["leaf", "leaf-list"] or "option" not in leaf or target is None:
+            raise XPathUnsupported("/".join(steps))
+        local = self.section_index is not None and kept > self.section_index and index == self.section_index
+        self.emit("XPATH_PATH", self.constant("paths", (
+            target["package"], target.get("section"), target.get("section-name"), leaf["option"], local)))
+
+
+def section_options(node):
+    """Returns the UCI options of a node that are stored in its own section"""
+    if node["type"] in ["leaf", "leaf-list"]:
+        return [node["option"]] if "option" in node else []
+    options = []
+    for child in node["map"].values():
+        if "section-name" in child or (child["type"] == "list" and "section" in child):
+            continue
+        options.extend(option for option in section_options(child) if option not in options)
+    return options
+
+
+def compile_constraint(code_name, path, ancestors, node, expression, when, constraints, tables):
+    target, index = uci_section(ancestors + [node])
+    options = section_options(node)
+    try:
+        if target is None or not options:
+            raise XPathUnsupported("node without UCI options")
+        # the context of when is the parent, the one of must is the node
+        context = ancestors if when else ancestors + [node]
+        code = XPathCompiler(expression, context, index, tables).compile()
+    except XPathUnsupported as unsupported:
+        print("Ignoring {} \"{}\" of {}: unsupported {}".format(
+            "when" if when else "must", expression, "/".join(path), unsupported), file=sys.stderr)
+        return
+    constraints.append({
+        "code_name": code_name,
+        "package": target["package"],
+        "section": target.get("section"),
+        "section_name": target.get("section-name"),
+        "options": options,
+        "when": 1 if when else 0,
+        "code": code
+    })
+
+
+def collect_constraints(module_name, ancestors, path, constraints, tables):
+    """Compiles the must and when statements of the nodes below a node
+
+    The expressions are dropped from the schema, the verification only needs
+    the compiled code.
+    """
+    for key, child in ancestors[-1]["map"].items():
+        parts = [module_name] + path + [key]
+        for index, expression in enumerate(child.pop("must", [])):
+            compile_constraint(c_identifier("must_", parts + [str(index)]), path + [key], ancestors, child,
+                               expression, False, constraints, tables)
+        if "when" in child:
+            compile_constraint(c_identifier("when_", parts), path + [key], ancestors, child, child.pop("when"),
+                               True, constraints, tables)
+        if child["type"] not in ["leaf", "leaf-list"]:
+            collect_constraints(module_name, ancestors + [child], path + [key], constraints, tables)
+
+
+def module_constraints(modules):
+    constraints = []
+    tables = {
+        "paths": [],
+        "strings": [],
+        "numbers": []
+    }
+    for name, module in modules:
+        collect_constraints(name, [module], [], constraints, tables)
+    return constraints, tables
+
+
 def main():
     parser = argparse.ArgumentParser(description='Preprocess YIN for OpenWrt RESTCONF')
 
@@ -237,10 +951,35 @@ def main():
     if not os.path.exists(args.output):
         os.makedirs(args.output)
 
+    leafrefs = []
+    for name, module in modules:
+        resolve_leafrefs([module], leafrefs)
+    constraints, constraint_tables = module_constraints(modules)
+    validators, tables = module_validators(modules)
+
     with open(os.path.join(args.output, "yang.h"), "w+") as out:
         rendered = header_file.render(modules=modules, types=types, ALLOWED_TYPES=ALLOWED_TYPES)
         out.write(rendered)
 
+    with open(os.path.join(args.output, "yang-emit.c"), "w+") as out:
+        rendered = emit_file.render(emitters=module_emitters(modules))
+        out.write(rendered)
+
+    with open(os.path.join(args.output, "yang-validate.c"), "w+") as out:
+        rendered = validate_file.render(validators=validators, patterns=tables["patterns"],
+                                        name_sets=tables["name_sets"], c_string=c_string)
+        out.write(rendered)
+
+    with open(os.path.join(args.output, "yang-constraint.c"), "w+") as out:
+        rendered = constraint_file.render(constraints=constraints, paths=constraint_tables["paths"],
+                                          strings=constraint_tables["strings"],
+                                          numbers=constraint_tables["numbers"], c_string=c_string)
+        out.write(rendered)
+
+    with open(os.path.join(args.output, "yang-leafref.c"), "w+") as out:
+        rendered = leafref_file.render(leafrefs=leafrefs, c_string=c_string)
+        out.write(rendered)
+
 
 if __name__ == '__main__':
     main()